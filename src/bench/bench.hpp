@@ -0,0 +1,386 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+/* Arena size of every benchmarked stalloc_t configuration (bytes) */
+inline constexpr size_t BENCH_ARENA = 1 << 20;
+
+/* Timed operations (allocations and de-allocations) per workload */
+inline constexpr size_t BENCH_OPS = 1 << 18;
+
+/* Live blocks kept by the random workload, and blocks per round of the
+ * LIFO/FIFO workloads and in flight in the producer/consumer workload */
+inline constexpr size_t BENCH_LIVE = 1024;
+inline constexpr size_t BENCH_ROUND = 256;
+
+/* Per-configuration entry points, one translation unit each (every
+ * implementation names its class stalloc_t) */
+void bench_implist();
+void bench_explist();
+void bench_tlsf();
+
+/**
+ * bench_rng_t
+ *
+ * Deterministic xorshift generator, so that every configuration
+ * sees the exact same sequence of requests.
+ */
+struct bench_rng_t {
+    uint32_t state;
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    /* Request size: mostly small objects, some buffers, a few large buffers */
+    size_t size() {
+        const uint32_t r = next();
+        switch (r % 20) {
+            case 0:          return 1024 + (r >> 8) % 3072;
+            case 1: case 2:
+            case 3: case 4:  return 128 + (r >> 8) % 896;
+            default:         return 16 + (r >> 8) % 112;
+        }
+    }
+};
+
+/**
+ * bench_stats_t
+ *
+ * Per-operation latencies and peak fragmentation of one workload run.
+ * Latencies include the cost of reading the clock, which is the same
+ * for every configuration.
+ */
+struct bench_stats_t {
+    std::vector<uint32_t> ns;
+    std::chrono::steady_clock::time_point t0;
+    double frag = -1;
+    size_t fails = 0;
+
+    bench_stats_t() { ns.reserve(BENCH_OPS); }
+
+    void start() { t0 = std::chrono::steady_clock::now(); }
+    void stop() {
+        const auto t1 = std::chrono::steady_clock::now();
+        ns.push_back((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    }
+
+    /* Record a fragmentation sample: the fraction of the arena not held
+     * by live requests that cannot be handed out as a single request */
+    void sample(const size_t largest, const size_t live) {
+        if (live < BENCH_ARENA)
+            frag = std::max(frag, 1. - (double)largest / (double)(BENCH_ARENA - live));
+    }
+};
+
+/**
+ * bench_arena_t
+ *
+ * Benchmark adapter for any stalloc_t (A, instantiated with T = void).
+ * The arena is heap allocated since it does not fit on the stack.
+ */
+template<typename A>
+struct bench_arena_t {
+    static constexpr bool FRAG = true;
+
+    std::unique_ptr<A> arena = std::make_unique<A>();
+
+    void* alloc(const size_t size) { return arena->alloc(size); }
+    void free(void* const p, const size_t) { arena->free(p); }
+    void free_remote(void* const p, const size_t) { arena->free_remote(p); }
+
+    /* Largest request that currently succeeds, by binary search (DSIZE steps) */
+    size_t largest() {
+        size_t lo = 0;
+        size_t hi = BENCH_ARENA / 16;
+        while (lo < hi) {
+            const size_t mid = (lo + hi + 1) / 2;
+            if (void* const p = arena->alloc(mid * 16)) {
+                arena->free(p);
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        return lo * 16;
+    }
+};
+
+/* Baseline: global malloc/free */
+struct bench_malloc_t {
+    static constexpr bool FRAG = false;
+
+    void* alloc(const size_t size) { return std::malloc(size); }
+    void free(void* const p, const size_t) { std::free(p); }
+    void free_remote(void* const p, const size_t) { std::free(p); }
+    size_t largest() { return 0; }
+};
+
+/* Baseline: std::pmr::monotonic_buffer_resource (de-allocation is a no-op) */
+struct bench_monotonic_t {
+    static constexpr bool FRAG = false;
+
+    std::pmr::monotonic_buffer_resource res;
+
+    void* alloc(const size_t size) { return res.allocate(size, 16); }
+    void free(void* const p, const size_t size) { res.deallocate(p, size, 16); }
+    void free_remote(void* const p, const size_t size) { res.deallocate(p, size, 16); }
+    size_t largest() { return 0; }
+};
+
+/* A live block and its request size */
+struct bench_blk_t {
+    void* p;
+    size_t size;
+};
+
+/* Timed allocation, recording failures */
+template<typename S>
+bench_blk_t bench_alloc(S& s, bench_stats_t& st, const size_t size) {
+    st.start();
+    void* const p = s.alloc(size);
+    st.stop();
+    if (!p)
+        st.fails++;
+    return {p, size};
+}
+
+/* Timed de-allocation */
+template<typename S>
+void bench_free(S& s, bench_stats_t& st, const bench_blk_t b) {
+    if (!b.p)
+        return;
+    st.start();
+    s.free(b.p, b.size);
+    st.stop();
+}
+
+/**
+ * bench_random()
+ *
+ * Random workload: each operation picks one of BENCH_LIVE slots, freeing
+ * its block if it holds one and allocating a block otherwise.
+ */
+template<typename S>
+void bench_random(S& s, bench_stats_t& st) {
+    bench_rng_t rng = {0x9e3779b9u};
+    std::vector<bench_blk_t> live(BENCH_LIVE, bench_blk_t{nullptr, 0});
+    size_t bytes = 0;
+
+    for (size_t n = 0; n < BENCH_OPS; n++) {
+        bench_blk_t& b = live[rng.next() % BENCH_LIVE];
+        if (b.p) {
+            bench_free(s, st, b);
+            bytes -= b.size;
+            b.p = nullptr;
+        } else if ((b = bench_alloc(s, st, rng.size())).p) {
+            bytes += b.size;
+        }
+
+        if (S::FRAG && n % 4096 == 4095)
+            st.sample(s.largest(), bytes);
+    }
+
+    for (bench_blk_t& b : live)
+        s.free(b.p, b.size);
+}
+
+/**
+ * bench_stack()
+ *
+ * LIFO (Reverse = true) or FIFO workload: rounds of BENCH_ROUND
+ * allocations, freed in reverse or in allocation order.
+ */
+template<typename S, bool Reverse>
+void bench_stack(S& s, bench_stats_t& st) {
+    bench_rng_t rng = {0x85ebca6bu};
+    std::vector<bench_blk_t> live(BENCH_ROUND);
+
+    for (size_t round = 0; round < BENCH_OPS / (2 * BENCH_ROUND); round++) {
+        size_t bytes = 0;
+        for (bench_blk_t& b : live)
+            bytes += (b = bench_alloc(s, st, rng.size())).p ? b.size : 0;
+
+        if (S::FRAG && round % 16 == 15)
+            st.sample(s.largest(), bytes);
+
+        for (size_t i = 0; i < BENCH_ROUND; i++)
+            bench_free(s, st, live[Reverse ? BENCH_ROUND - 1 - i : i]);
+    }
+}
+
+/**
+ * bench_prodcons()
+ *
+ * Producer/consumer workload: the owning thread allocates blocks and
+ * hands them to a consumer thread through a ring of BENCH_ROUND slots.
+ * The consumer frees them with free_remote(). Fragmentation is not
+ * sampled as the arena is in use by both threads.
+ */
+template<typename S>
+void bench_prodcons(S& s, bench_stats_t& st) {
+    std::vector<std::atomic<void*>> ring(BENCH_ROUND);
+    std::vector<size_t> sizes(BENCH_ROUND);
+    bench_stats_t cst;
+    constexpr size_t count = BENCH_OPS / 2;
+
+    for (std::atomic<void*>& slot : ring)
+        slot.store(nullptr);
+
+    std::thread consumer([&s, &ring, &sizes, &cst] {
+        for (size_t n = 0; n < count; n++) {
+            std::atomic<void*>& slot = ring[n % BENCH_ROUND];
+            void* p;
+            while (!(p = slot.load(std::memory_order_acquire)))
+                std::this_thread::yield();
+            const size_t size = sizes[n % BENCH_ROUND];
+            slot.store(nullptr, std::memory_order_relaxed);
+
+            cst.start();
+            s.free_remote(p, size);
+            cst.stop();
+        }
+    });
+
+    bench_rng_t rng = {0xc2b2ae35u};
+    for (size_t n = 0; n < count; n++) {
+        std::atomic<void*>& slot = ring[n % BENCH_ROUND];
+        while (slot.load(std::memory_order_acquire))
+            std::this_thread::yield();
+
+        const size_t size = rng.size();
+        bench_blk_t b;
+        while (!(b = bench_alloc(s, st, size)).p)
+            std::this_thread::yield();
+        sizes[n % BENCH_ROUND] = size;
+        slot.store(b.p, std::memory_order_release);
+    }
+    consumer.join();
+
+    st.ns.insert(st.ns.end(), cst.ns.begin(), cst.ns.end());
+}
+
+/**
+ * bench_trace()
+ *
+ * Message decoder trace: every message allocates a burst of small nodes
+ * and one or two buffers, then frees them all once decoded. One node
+ * in sixteen outlives its message and is kept in a FIFO of BENCH_LIVE
+ * long-lived objects, which slowly fragments the arena.
+ */
+template<typename S>
+void bench_trace(S& s, bench_stats_t& st) {
+    bench_rng_t rng = {0x27d4eb2fu};
+    std::vector<bench_blk_t> kept(BENCH_LIVE, bench_blk_t{nullptr, 0});
+    std::vector<bench_blk_t> msg;
+    size_t kidx = 0;
+    size_t kbytes = 0;
+
+    for (size_t n = 0, m = 0; n < BENCH_OPS; m++) {
+        const size_t nodes = 8 + rng.next() % 56;
+        const size_t bufs = 1 + rng.next() % 2;
+        size_t bytes = kbytes;
+
+        msg.clear();
+        for (size_t i = 0; i < bufs; i++)
+            msg.push_back(bench_alloc(s, st, 256 + rng.next() % 3840));
+        for (size_t i = 0; i < nodes; i++)
+            msg.push_back(bench_alloc(s, st, 24 + 8 * (rng.next() % 6)));
+        for (const bench_blk_t& b : msg)
+            bytes += b.p ? b.size : 0;
+
+        if (S::FRAG && m % 64 == 63)
+            st.sample(s.largest(), bytes);
+
+        for (size_t i = 0; i < msg.size(); i++) {
+            if (i >= bufs && msg[i].p && rng.next() % 16 == 0) {
+                bench_free(s, st, kept[kidx]);
+                kbytes += msg[i].size - (kept[kidx].p ? kept[kidx].size : 0);
+                kept[kidx] = msg[i];
+                kidx = (kidx + 1) % BENCH_LIVE;
+            } else {
+                bench_free(s, st, msg[i]);
+            }
+        }
+        n += 2 * msg.size();
+    }
+
+    for (bench_blk_t& b : kept)
+        s.free(b.p, b.size);
+}
+
+/* Print the table header */
+inline void bench_header() {
+    printf("%-26s %-9s %8s %8s %8s %8s %9s %7s %6s\n",
+           "Configuration", "Workload", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "max ns", "frag %", "fails");
+    printf("%-26s %-9s %8s %8s %8s %8s %9s %7s %6s\n",
+           "-------------", "--------", "------", "------", "------", "--------", "------", "------", "-----");
+}
+
+/* Print one row of results */
+inline void bench_report(const char* name, const char* workload, bench_stats_t& st) {
+    std::vector<uint32_t>& ns = st.ns;
+    std::sort(ns.begin(), ns.end());
+
+    auto pct = [&ns](const double p) { return ns.empty() ? 0u : ns[(size_t)(p * (ns.size() - 1))]; };
+
+    char frag[16] = "-";
+    if (st.frag >= 0)
+        snprintf(frag, sizeof(frag), "%.1f", 100. * st.frag);
+
+    printf("%-26s %-9s %8u %8u %8u %8u %9u %7s %6zu\n",
+           name, workload, pct(.5), pct(.9), pct(.99), pct(.999), ns.empty() ? 0u : ns.back(), frag, st.fails);
+}
+
+/**
+ * bench_run()
+ *
+ * Run every workload on a fresh instance of adapter S and report one
+ * row per workload.
+ */
+template<typename S>
+void bench_run(const char* name) {
+    {
+        S s;
+        bench_stats_t st;
+        bench_random(s, st);
+        bench_report(name, "random", st);
+    }
+    {
+        S s;
+        bench_stats_t st;
+        bench_stack<S, true>(s, st);
+        bench_report(name, "lifo", st);
+    }
+    {
+        S s;
+        bench_stats_t st;
+        bench_stack<S, false>(s, st);
+        bench_report(name, "fifo", st);
+    }
+    {
+        S s;
+        bench_stats_t st;
+        bench_prodcons(s, st);
+        bench_report(name, "prodcons", st);
+    }
+    {
+        S s;
+        bench_stats_t st;
+        bench_trace(s, st);
+        bench_report(name, "trace", st);
+    }
+}
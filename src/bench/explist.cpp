@@ -0,0 +1,21 @@
+#include "../explist/stalloc.hpp"
+#include "bench.hpp"
+
+void bench_explist() {
+    bench_run<bench_arena_t<stalloc_t<BENCH_ARENA, void, stalloc_fit_t::first_fit,
+                                      stalloc_ord_t::lifo_order>>>("explist first_fit lifo");
+    bench_run<bench_arena_t<stalloc_t<BENCH_ARENA, void, stalloc_fit_t::first_fit,
+                                      stalloc_ord_t::addr_order>>>("explist first_fit addr");
+    bench_run<bench_arena_t<stalloc_t<BENCH_ARENA, void, stalloc_fit_t::first_fit,
+                                      stalloc_ord_t::addr_order, stalloc_ftr_t::keep_ftrs, stalloc_tag_t::wide_tags,
+                                      stalloc_coa_t::lazy_coalesce>>>("explist addr lazy");
+    bench_run<bench_arena_t<stalloc_t<BENCH_ARENA, void, stalloc_fit_t::best_fit,
+                                      stalloc_ord_t::lifo_order>>>("explist best_fit lifo");
+    bench_run<bench_arena_t<stalloc_t<BENCH_ARENA, void, stalloc_fit_t::best_fit,
+                                      stalloc_ord_t::addr_order>>>("explist best_fit addr");
+    bench_run<bench_arena_t<stalloc_t<BENCH_ARENA, void, stalloc_fit_t::first_fit,
+                                      stalloc_ord_t::seg_order>>>("explist first_fit seg");
+    bench_run<bench_arena_t<stalloc_t<BENCH_ARENA, void, stalloc_fit_t::first_fit,
+                                      stalloc_ord_t::seg_order, stalloc_ftr_t::keep_ftrs,
+                                      stalloc_tag_t::compact_tags>>>("explist seg compact");
+}
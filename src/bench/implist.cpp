@@ -0,0 +1,7 @@
+#include "../implist/stalloc.hpp"
+#include "bench.hpp"
+
+void bench_implist() {
+    bench_run<bench_arena_t<stalloc_t<BENCH_ARENA, void, stalloc_fit_t::first_fit>>>("implist first_fit");
+    bench_run<bench_arena_t<stalloc_t<BENCH_ARENA, void, stalloc_fit_t::best_fit>>>("implist best_fit");
+}
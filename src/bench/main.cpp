@@ -0,0 +1,19 @@
+#include <iostream>
+#include "bench.hpp"
+
+#define pr_inf "inf[" << __func__ << "]: "
+#define pr_err "err[" << __func__ << "]: "
+
+int main() {
+    std::cout << std::endl << pr_inf << "running " << BENCH_OPS << " operations per workload ("
+              << (BENCH_ARENA >> 10) << "KB arenas)..." << std::endl << std::endl;
+
+    bench_header();
+    bench_implist();
+    bench_explist();
+    bench_tlsf();
+    bench_run<bench_malloc_t>("malloc/free");
+    bench_run<bench_monotonic_t>("monotonic_buffer_resource");
+
+    return 0;
+}
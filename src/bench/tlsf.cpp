@@ -0,0 +1,6 @@
+#include "../tlsf/stalloc.hpp"
+#include "bench.hpp"
+
+void bench_tlsf() {
+    bench_run<bench_arena_t<stalloc_t<BENCH_ARENA>>>("tlsf");
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+/**
+ * stalloc_bump_t
+ *
+ * Monotonic (bump) front-end for any stalloc_t (A, instantiated with
+ * T = void), which it does not own. Chunks of at least ChunkSize bytes
+ * are carved out of the wrapped allocator, and alloc() moves a pointer
+ * through the newest chunk: no boundary tags, free lists or coalescing.
+ * free() does nothing.
+ *
+ * Memory is handed back to the wrapped allocator, one free() per
+ * chunk, by release_to() a checkpoint taken with mark() (or by the
+ * stalloc_scope_t guard), by release(), or on destruction. Other users
+ * of the wrapped allocator keep using it as a general allocator in the
+ * meantime. Checkpoints must be released in LIFO order.
+ */
+template<typename A, typename T = void, size_t ChunkSize = 1024>
+class stalloc_bump_t {
+    /* Word and double-word sizes, architecture dependant (bytes) */
+    static constexpr size_t WSIZE = sizeof(void*);
+    static constexpr size_t DSIZE = 2 * WSIZE;
+
+    /* Alignment helpers */
+    static constexpr size_t ALIGN_MASK(size_t x, size_t m) { return (x + m) & (~m); }
+    static constexpr size_t ALIGN_UP(size_t x) { return ALIGN_MASK(x, DSIZE-1); }
+
+    /* Chunk header, stored at the start of every chunk. Chunks are
+     * linked newest to oldest */
+    struct chunk_t {
+        chunk_t* prev;
+        size_t size;
+    };
+
+    static constexpr size_t CHUNK_HDR = ALIGN_UP(sizeof(chunk_t));
+
+    /* Pointer type handed out by the wrapped allocator */
+    using AT = decltype(std::declval<A&>().alloc(0));
+
+    /* Ensure T is a trivially copyable type (or void) */
+    static_assert(std::is_trivially_copyable_v<T> || std::is_void_v<T>);
+
+    /* Ensure chunks are double-word aligned and fit more than their header */
+    static_assert(((ChunkSize & (DSIZE-1)) == 0) && (ChunkSize > CHUNK_HDR));
+
+    /* Wrapped blocks are aligned to less than DSIZE (compact tags), chunks are carved
+     * with alloc_aligned() so that headers and blocks stay double-word aligned */
+    static constexpr bool NARROW = requires { requires A::ALIGNMENT < DSIZE; };
+    static_assert(!NARROW || requires (A& a) { a.alloc_aligned(ChunkSize, DSIZE); });
+
+    public:
+        /* Checkpoint: newest chunk and bump pointer */
+        struct mark_t {
+            chunk_t* chunk;
+            unsigned char* top;
+        };
+
+    private:
+        A* m_arena;
+        chunk_t* m_chunk = nullptr;
+        unsigned char* m_top = nullptr;
+        unsigned char* m_end = nullptr;
+
+        T* grow(const size_t asize);
+
+        void* chunk_alloc(const size_t csize) {
+            if constexpr (NARROW)
+                return static_cast<void*>(m_arena->alloc_aligned(csize, DSIZE));
+            else
+                return static_cast<void*>(m_arena->alloc(csize));
+        }
+
+    public:
+        explicit stalloc_bump_t(A& arena) noexcept : m_arena(&arena) {}
+        ~stalloc_bump_t() { release(); }
+
+        stalloc_bump_t(const stalloc_bump_t&) = delete;
+        stalloc_bump_t& operator=(const stalloc_bump_t&) = delete;
+
+        [[nodiscard]] T* alloc(const size_t size);
+        void free(T* const) {}
+
+        /* Checkpoints */
+        [[nodiscard]] mark_t mark() const { return {m_chunk, m_top}; }
+        void release_to(const mark_t& m);
+        void release() { release_to({nullptr, nullptr}); }
+
+        /* Wrapped allocator */
+        A& arena() { return *m_arena; }
+};
+
+/**
+ * stalloc_bump_t::grow()
+ *
+ * Carve a new chunk out of the wrapped allocator and allocate from
+ * it. Chunks are ChunkSize bytes, or just large enough for bigger
+ * requests (or when a full chunk no longer fits), and double-word
+ * aligned even over allocators with a smaller block alignment.
+ * Returns nullptr if the wrapped allocator has no room.
+ */
+template<typename A, typename T, size_t ChunkSize>
+T* stalloc_bump_t<A, T, ChunkSize>::grow(const size_t asize) {
+    size_t csize = (asize + CHUNK_HDR > ChunkSize) ? asize + CHUNK_HDR : ChunkSize;
+    void* cp = chunk_alloc(csize);
+
+    if (!cp && csize > asize + CHUNK_HDR) {
+        csize = asize + CHUNK_HDR;
+        cp = chunk_alloc(csize);
+    }
+    if (!cp)
+        return nullptr;
+
+    chunk_t* const chp = static_cast<chunk_t*>(cp);
+    chp->prev = m_chunk;
+    chp->size = csize;
+
+    m_chunk = chp;
+    m_top = (unsigned char*)cp + CHUNK_HDR + asize;
+    m_end = (unsigned char*)cp + csize;
+    return static_cast<T*>((void*)((unsigned char*)cp + CHUNK_HDR));
+}
+
+/**
+ * stalloc_bump_t::alloc()
+ *
+ * Public facing allocation subroutine. Bumps the top of the newest
+ * chunk, carving a new chunk when it is full. Returns nullptr on
+ * failure.
+ *
+ * Blocks are always double-word aligned.
+ */
+template<typename A, typename T, size_t ChunkSize>
+T* stalloc_bump_t<A, T, ChunkSize>::alloc(const size_t size) {
+    /* Ignore zero-sized and overflowing requests */
+    if (!size || size > SIZE_MAX - ChunkSize)
+        return nullptr;
+
+    const size_t asize = ALIGN_UP(size);
+
+    if ((size_t)(m_end - m_top) >= asize) [[likely]] {
+        unsigned char* const bp = m_top;
+        m_top += asize;
+        return static_cast<T*>((void*)bp);
+    }
+    return grow(asize);
+}
+
+/**
+ * stalloc_bump_t::release_to()
+ *
+ * Release everything allocated since the given checkpoint. Chunks
+ * carved since then are returned to the wrapped allocator.
+ */
+template<typename A, typename T, size_t ChunkSize>
+void stalloc_bump_t<A, T, ChunkSize>::release_to(const mark_t& m) {
+    while (m_chunk != m.chunk) {
+        chunk_t* const prev = m_chunk->prev;
+        m_arena->free(static_cast<AT>(static_cast<void*>(m_chunk)));
+        m_chunk = prev;
+    }
+
+    m_top = m.top;
+    m_end = m_chunk ? (unsigned char*)m_chunk + m_chunk->size : nullptr;
+}
+
+/**
+ * stalloc_scope_t
+ *
+ * Scope guard over a stalloc_bump_t (B). Takes a checkpoint on
+ * construction and releases back to it on destruction.
+ */
+template<typename B>
+class stalloc_scope_t {
+    private:
+        B& m_bump;
+        const typename B::mark_t m_mark;
+
+    public:
+        explicit stalloc_scope_t(B& bump) : m_bump(bump), m_mark(bump.mark()) {}
+        ~stalloc_scope_t() { m_bump.release_to(m_mark); }
+
+        stalloc_scope_t(const stalloc_scope_t&) = delete;
+        stalloc_scope_t& operator=(const stalloc_scope_t&) = delete;
+};
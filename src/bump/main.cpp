@@ -0,0 +1,116 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include "../explist/stalloc.hpp"
+#include "bump.hpp"
+
+#define pr_inf "inf[" << __func__ << "]: "
+#define pr_err "err[" << __func__ << "]: "
+
+int main() {
+    stalloc_t<4096> st;
+    stalloc_bump_t<stalloc_t<4096>, int, 1024> bst(st);
+
+    int* i = nullptr;
+    int* j = nullptr;
+    int* k = nullptr;
+
+    /* Allocate three 16B blocks. These should be adjacent within one chunk */
+    std::cout << std::endl << pr_inf << "allocating three 16B blocks" << std::endl;
+    i = bst.alloc(4 * sizeof(int));
+    j = bst.alloc(4 * sizeof(int));
+    k = bst.alloc(4 * sizeof(int));
+    assert(i && j && k);
+    assert(j == i + 4 && k == j + 4);
+    st.printb();
+
+    /* The general allocator keeps working alongside the bump allocator */
+    std::cout << std::endl << pr_inf << "allocating a 256B block from the general allocator" << std::endl;
+    void* p = st.alloc(256);
+    assert(p);
+
+    /* Blocks past a checkpoint are released together, chunks carved since are returned */
+    std::cout << std::endl << pr_inf << "allocating 100 16B blocks past a checkpoint" << std::endl;
+    const auto m = bst.mark();
+    for (int n = 0; n < 100; n++)
+        assert(bst.alloc(4 * sizeof(int)));
+    st.printb();
+
+    std::cout << std::endl << pr_inf << "releasing to the checkpoint" << std::endl;
+    bst.release_to(m);
+    st.printb();
+    assert(bst.alloc(4 * sizeof(int)) == k + 4);
+
+    /* Scope guard */
+    std::cout << std::endl << pr_inf << "allocating 2KB in a scope" << std::endl;
+    {
+        stalloc_scope_t scope(bst);
+        i = bst.alloc(512 * sizeof(int));
+        assert(i);
+        for (int x = 0; x < 512; x++)
+            i[x] = x;
+        assert(i[511] == 511);
+    }
+    assert(bst.alloc(4 * sizeof(int)) == k + 8);
+
+    /* Everything is handed back to the general allocator at once */
+    std::cout << std::endl << pr_inf << "releasing all chunks, freeing the 256B block" << std::endl;
+    bst.release();
+    st.free(p);
+    st.printb();
+    p = st.alloc(4064);
+    assert(p);
+
+    /* No room for a chunk */
+    std::cout << pr_inf << "trying to allocate with a full general allocator" << std::endl;
+    assert(!bst.alloc(4 * sizeof(int)));
+    st.free(p);
+    p = nullptr;
+    i = j = k = nullptr;
+
+    /* Compact tag arenas only align blocks to 4 or 8 bytes, chunks carved out of them must still be aligned */
+    std::cout << std::endl << pr_inf << "allocating from chunks of a compact tag arena" << std::endl;
+    using cst_t = stalloc_t<4096, void, stalloc_fit_t::first_fit, stalloc_ord_t::lifo_order,
+                            stalloc_ftr_t::keep_ftrs, stalloc_tag_t::compact_tags>;
+    cst_t cst;
+    void* cp = cst.alloc(4);
+    assert(cp && ((size_t)cp & (2 * sizeof(void*) - 1)));
+    {
+        stalloc_bump_t<cst_t, int, 1024> cbst(cst);
+        for (int idx = 0; idx < 64; idx++) {
+            i = cbst.alloc(1 + idx % 24);
+            assert(i && ((size_t)i & (2 * sizeof(void*) - 1)) == 0);
+        }
+    }
+    cst.free(cp);
+    cp = nullptr;
+    i = nullptr;
+    cst.printb();
+
+    /* Allocate 126 16B blocks and throw them away, many times */
+    std::cout << std::endl << pr_inf << "running performance test (65,536 loops)..." << std::endl;
+    int* abuf[126] = {nullptr};
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int l = 0; l < 65536; l++) {
+        stalloc_scope_t scope(bst);
+        for (int idx = 0; idx < 126; idx++)
+            abuf[idx] = bst.alloc(4 * sizeof(int));
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "stalloc_bump_t done [" << dur_time.count() / 1000. << "s]" << std::endl;
+    assert(abuf[125]);
+
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int l = 0; l < 65536; l++) {
+        for (int idx = 0; idx < 126; idx++)
+            abuf[idx] = static_cast<int*>(st.alloc(4 * sizeof(int)));
+        for (int idx = 0; idx < 126; idx++)
+            st.free(abuf[idx]);
+    }
+    end_time = std::chrono::high_resolution_clock::now();
+    dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "stalloc_t done [" << dur_time.count() / 1000. << "s]" << std::endl;
+
+    return 0;
+}
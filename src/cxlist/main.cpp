@@ -0,0 +1,171 @@
+#include <iostream>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include "stalloc.hpp"
+
+#define pr_inf "inf[" << __func__ << "]: "
+#define pr_err "err[" << __func__ << "]: "
+
+/* Linked list node, linked by cell offset */
+struct node_t {
+    int val;
+    uint32_t next;
+};
+
+/* Build a linked list of the first n squares, free every second node and
+ * sum the rest by walking the list, all in constant evaluation */
+constexpr int list_sum(const int n) {
+    stalloc_t<1024, node_t> st;
+    node_t* nodes[64] = {nullptr};
+    uint32_t head = UINT32_MAX;
+
+    for (int i = n - 1; i >= 0; i--) {
+        nodes[i] = st.alloc(sizeof(node_t));
+        nodes[i]->val = i * i;
+        nodes[i]->next = head;
+        head = (uint32_t)st.offset(nodes[i]);
+    }
+    for (int i = 1; i < n; i += 2) {
+        nodes[i - 1]->next = nodes[i]->next;
+        st.free(nodes[i]);
+    }
+
+    int sum = 0;
+    for (uint32_t off = head; off != UINT32_MAX; off = st.ptr(off)->next)
+        sum += st.ptr(off)->val;
+    return sum;
+}
+
+/* Allocate, free and re-allocate blocks of mixed size, returning the offsets of
+ * the final allocations (freed blocks should be reused, first fit). Every block
+ * has a one-cell header and footer */
+constexpr std::array<size_t, 4> offsets() {
+    stalloc_t<64 * sizeof(int), int> st;
+    int* a = st.alloc(8 * sizeof(int));
+    int* b = st.alloc(4 * sizeof(int));
+    int* c = st.alloc(16 * sizeof(int));
+    st.free(a);
+    st.free(b);
+    int* d = st.alloc(10 * sizeof(int));
+    int* e = st.alloc(2 * sizeof(int));
+    return {st.offset(c), st.offset(d), st.offset(e), st.usable_size(e)};
+}
+
+/* Check that tags of char cells span four cells at each end of a block */
+constexpr bool char_cells() {
+    stalloc_t<64, char> st;
+    char* a = st.alloc(3);
+    char* b = st.alloc(5);
+    const bool placed = (st.offset(a) == 4) && (st.offset(b) == 15) && (st.usable_size(b) == 5);
+    st.free(a);
+    st.free(b);
+    return placed && st.can_alloc(56) && !st.can_alloc(57);
+}
+
+/* Sum over a table allocated and filled at compile time (plus its header and footer) */
+constexpr int table_sum() {
+    stalloc_t<258 * sizeof(int), int> st;
+    int* t = st.alloc(256 * sizeof(int));
+    for (int i = 0; i < 256; i++)
+        t[i] = i;
+    int sum = 0;
+    for (int i = 0; i < 256; i++)
+        sum += t[i];
+    st.free(t);
+    return st.can_alloc(256 * sizeof(int)) ? sum : -1;
+}
+
+int main() {
+    /* Constant evaluation */
+    std::cout << std::endl << pr_inf << "checking compile-time evaluated allocations" << std::endl;
+    static_assert(list_sum(10) == 0 + 4 + 16 + 36 + 64);
+    static_assert(offsets() == std::array<size_t, 4>{17, 1, 13, 2 * sizeof(int)});
+    static_assert(table_sum() == 255 * 256 / 2);
+    static_assert(char_cells());
+    assert(list_sum(10) == 120);
+
+    /* Integral cells hold their tags in-band, instead of one out of band tag per cell */
+    struct oob_layout_t {
+        int data[1024];
+        uint32_t tags[1024];
+    };
+    static_assert(sizeof(stalloc_t<4096, int>) == 4096 && sizeof(oob_layout_t) == 8192);
+    static_assert(sizeof(stalloc_t<4096, char>) == 4096);
+    static_assert(sizeof(stalloc_t<1024, node_t>) == 1024 + 128 * sizeof(uint32_t));
+
+    stalloc_t<4096, int> st;
+
+    int* i = nullptr;
+    int* j = nullptr;
+    int* k = nullptr;
+
+    /* Allocate and free three 16B blocks. Each takes a header and footer cell */
+    std::cout << std::endl << pr_inf << "allocating three 16B blocks" << std::endl;
+    i = st.alloc(4 * sizeof(int));
+    j = st.alloc(4 * sizeof(int));
+    k = st.alloc(4 * sizeof(int));
+    st.printb();
+    assert(j == i + 6 && k == j + 6);
+
+    std::cout << std::endl << pr_inf << "freeing j (" << j << ")" << std::endl;
+    st.free(j);
+    st.printb();
+
+    /* Invalid frees are ignored */
+    st.free(j);
+    st.free(i + 1);
+    st.free(k + 6);
+    int x = 0;
+    st.free(&x);
+    assert(st.usable_size(i) == 16 && st.usable_size(j) == 0);
+
+    std::cout << std::endl << pr_inf << "freeing i and k" << std::endl;
+    st.free(i);
+    st.free(k);
+    i = j = k = nullptr;
+    st.printb();
+
+    /* The whole buffer is usable, less one header and footer */
+    std::cout << std::endl << pr_inf << "allocating block of max size" << std::endl;
+    assert(!st.alloc(4096 - sizeof(int)));
+    i = st.alloc(4096 - 2 * sizeof(int));
+    assert(i && !st.alloc(1) && !st.can_alloc(1));
+    st.free(i);
+    i = nullptr;
+    assert(!st.alloc(4097));
+
+    /* Metadata is offsets, so a copy of the allocator is a working allocator */
+    std::cout << std::endl << pr_inf << "relocating an allocator with live blocks" << std::endl;
+    i = st.alloc(4 * sizeof(int));
+    j = st.alloc(4 * sizeof(int));
+    i[3] = 3;
+    const size_t joff = st.offset(j);
+    st.free(i);
+
+    stalloc_t<4096, int> cst = st;
+    int* const cj = cst.ptr(joff);
+    assert(cst.usable_size(cj) == 16 && cst.alloc(4 * sizeof(int)) == cst.ptr(1));
+    cst.free(cj);
+    cst.free(cst.ptr(1));
+    assert(cst.can_alloc(4096 - 2 * sizeof(int)));
+    st.free(j);
+    i = j = nullptr;
+
+    /* Allocate and free entire buffer many times */
+    std::cout << std::endl << pr_inf << "running performance test (65,536 loops)..." << std::endl;
+    int* abuf[126] = {nullptr};
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int l = 0; l < 65536; l++) {
+        for (int idx = 0; idx < 126; idx++)
+            abuf[idx] = st.alloc(4 * sizeof(int));
+        for (int idx = 125; idx >= 0; idx--)
+            st.free(abuf[idx]);
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "performance test done [" << dur_time.count() / 1000. << "s]" << std::endl;
+    assert(abuf[125] == st.ptr(751));
+
+    return 0;
+}
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+
+enum stalloc_fit_t { first_fit, best_fit };
+
+/**
+ * stalloc_t (constexpr implicit list)
+ *
+ * Implicit free list allocator usable in constant evaluation. The
+ * buffer is an array of MaxSize / sizeof(T) cells of type T, and
+ * boundary tags are 32-bit words holding block sizes as cell counts.
+ * Blocks are identified by their cell offset, so no tag ever holds a
+ * pointer and nothing is reinterpreted: every member function except
+ * printb() is constexpr, and the allocator (with its blocks) can be
+ * copied or moved as a whole.
+ *
+ * With integral cells, tags are kept in-band as cell values: a
+ * block's header fills its first TAG_CELLS cells and its footer its
+ * last, as with HDRP/FTRP in the byte-buffer lists. Other cell types
+ * cannot hold a tag in constant evaluation, so their tags are kept
+ * out of band in a parallel array, one per cell, where a block's
+ * header is the tag of its first cell and its footer the tag of its
+ * last, and blocks carry no in-band overhead.
+ *
+ * Tags left inside merged blocks are zero.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F = stalloc_fit_t::first_fit>
+class stalloc_t {
+    /* Boundary tag: block size in cells and alloc bit */
+    using tag_t = uint32_t;
+
+    /* Number of cells in the buffer */
+    static constexpr size_t CELLS = MaxSize / sizeof(T);
+
+    /* In-band tags (integral cells), and the cells each tag spans */
+    static constexpr bool INBAND = std::is_integral_v<T> && !std::is_same_v<T, bool>;
+    static constexpr size_t TAG_CELLS = (sizeof(tag_t) + sizeof(T) - 1) / sizeof(T);
+
+    /* Cells before the payload, and from the footer tag to the end of a block */
+    static constexpr size_t HDR_CELLS = INBAND ? TAG_CELLS : 0;
+    static constexpr size_t FTR_CELLS = INBAND ? TAG_CELLS : 1;
+
+    /* Smallest block, which has room for distinct header and footer tags */
+    static constexpr size_t MIN_CELLS = INBAND ? 2 * TAG_CELLS : 1;
+
+    /* Pack size and alloc bit into a tag */
+    static constexpr tag_t PACK(size_t size, bool alloc) { return (tag_t)((size << 1) | alloc); }
+
+    /* Read size and alloc fields from a tag */
+    static constexpr size_t GET_SIZE(tag_t t) { return t >> 1; }
+    static constexpr bool GET_ALLOC(tag_t t) { return t & 0x1; }
+
+    /* Read/write the tag at a cell index */
+    constexpr tag_t GET(size_t i) const {
+        if constexpr (INBAND) {
+            tag_t t = 0;
+            for (size_t k = 0; k < TAG_CELLS; k++)
+                t |= (tag_t)(std::make_unsigned_t<T>)m_data[i + k] << (k * 8 * sizeof(T));
+            return t;
+        } else {
+            return m_tags[i];
+        }
+    }
+    constexpr void PUT(size_t i, tag_t t) {
+        if constexpr (INBAND) {
+            for (size_t k = 0; k < TAG_CELLS; k++)
+                m_data[i + k] = (T)(std::make_unsigned_t<T>)(t >> (k * 8 * sizeof(T)));
+        } else {
+            m_tags[i] = t;
+        }
+    }
+
+    /* Get header/footer index from block index */
+    static constexpr size_t HDRI(size_t b) { return b; }
+    constexpr size_t FTRI(size_t b) const { return b + GET_SIZE(GET(b)) - FTR_CELLS; }
+
+    /* Get next/previous blocks from block index */
+    constexpr size_t NEXT_BLKI(size_t b) const { return b + GET_SIZE(GET(b)); }
+    constexpr size_t PREV_BLKI(size_t b) const { return b - GET_SIZE(GET(b - FTR_CELLS)); }
+
+    /* Check if next/previous blocks exist (i.e. if current block is at boundary) */
+    static constexpr bool PREV_EXIST(size_t b) { return b > 0; }
+    constexpr bool NEXT_EXIST(size_t b) const { return NEXT_BLKI(b) < CELLS; }
+
+    /* Number of cells needed for a request (bytes), tags included */
+    static constexpr size_t ALIGN_SIZE(size_t x) { return (x + sizeof(T) - 1) / sizeof(T) + 2 * HDR_CELLS; }
+
+    /* Ensure T is a trivially copyable, default constructible type */
+    static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>);
+
+    /* Ensure MaxSize is a multiple of the cell size and sizes fit a tag */
+    static_assert((MaxSize % sizeof(T) == 0) && (CELLS >= MIN_CELLS) && (CELLS < ((size_t)1 << 31)));
+
+    /* Index returned by find_fit() on failure */
+    static constexpr size_t NONE = CELLS;
+
+    private:
+        /* Placeholder for out of band tags when tags are in-band */
+        struct tags_none_t {};
+
+        T m_data[CELLS] = {};
+        [[no_unique_address]] std::conditional_t<INBAND, tags_none_t, tag_t[CELLS]> m_tags = {};
+
+        constexpr size_t find_fit(const size_t asize) const;
+        constexpr void place(const size_t b, size_t asize);
+        constexpr void coalesce(const size_t b);
+
+        /* Get block index from block pointer, NONE if not in the buffer */
+        constexpr size_t index(const T* const bp) const;
+
+    public:
+        constexpr stalloc_t() {
+            PUT(HDRI(0), PACK(CELLS, false));
+            PUT(CELLS - FTR_CELLS, PACK(CELLS, false));
+        };
+
+        [[nodiscard]] constexpr T* alloc(const size_t size);
+        constexpr void free(T* const bp);
+        [[nodiscard]] constexpr size_t usable_size(const T* const bp) const;
+        [[nodiscard]] constexpr bool can_alloc(const size_t size) const;
+
+        /* Relocatable handles: cell offset of a block, and block at an offset */
+        [[nodiscard]] constexpr size_t offset(const T* const bp) const { return (index(bp) == NONE) ? NONE : index(bp) + HDR_CELLS; }
+        [[nodiscard]] constexpr T* ptr(const size_t off) { return (off < CELLS) ? m_data + off : nullptr; }
+
+        /* Debug */
+        void printb() const;
+};
+
+/**
+ * stalloc_t::printb()
+ *
+ * Print a formatted representation of the instantiated stack
+ * allocator's block list. Sizes are in bytes.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F>
+void stalloc_t<MaxSize, T, F>::printb() const {
+    printf("+------------------------------------------------+\n"
+           "|                      Stack                     |\n"
+           "+-------+----------------+--------------+--------+\n"
+           "| Block |     Offset     |     Size     | Status |\n"
+           "+-------+----------------+--------------+--------+\n");
+
+    int i = 0;
+    for (size_t b = 0; b < CELLS; b = NEXT_BLKI(b), i++) {
+        printf("| %-6d| %-15ld| %-13ld|   %c    |\n"
+               "+-------+----------------+--------------+--------+\n",
+                i, b * sizeof(T), GET_SIZE(GET(b)) * sizeof(T), (GET_ALLOC(GET(b)) ? 'A' : 'F'));
+    }
+}
+
+/**
+ * stalloc_t::index()
+ *
+ * Get the index of the block at the given pointer. Pointers outside
+ * the buffer (only checked at runtime), and pointers not at the start
+ * of the payload of an allocated block, give NONE.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F>
+constexpr size_t stalloc_t<MaxSize, T, F>::index(const T* const bp) const {
+    if (!bp)
+        return NONE;
+
+    /* Pointers into other objects cannot be compared in constant evaluation */
+    if (!std::is_constant_evaluated() &&
+            ((uintptr_t)bp < (uintptr_t)m_data || (uintptr_t)bp >= (uintptr_t)(m_data + CELLS)))
+        return NONE;
+
+    if ((size_t)(bp - m_data) < HDR_CELLS)
+        return NONE;
+
+    const size_t b = bp - m_data - HDR_CELLS;
+    if (!GET_ALLOC(GET(b)) || GET_SIZE(GET(b)) < MIN_CELLS || NEXT_BLKI(b) > CELLS || GET(FTRI(b)) != GET(b))
+        return NONE;
+    return b;
+}
+
+/**
+ * stalloc_t::find_fit()
+ *
+ * Free block fit finder. Returns the index of the allotted
+ * block if fit is found. Otherwise returns NONE.
+ *
+ * Fit algorithm may be chosen at compile time/instantiation
+ * via the stalloc_fit_t type template parameter. Defaults to
+ * stalloc_type_t::first_fit.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F>
+constexpr size_t stalloc_t<MaxSize, T, F>::find_fit(const size_t asize) const {
+    /* First Fit */
+    if constexpr (F == stalloc_fit_t::first_fit) {
+        for (size_t b = 0; b < CELLS; b = NEXT_BLKI(b))
+            if (!GET_ALLOC(GET(b)) && asize <= GET_SIZE(GET(b)))
+                return b;
+        return NONE;
+    }
+    /* Best Fit */
+    if constexpr (F == stalloc_fit_t::best_fit) {
+        size_t bb = NONE;
+        size_t bb_size = ~((size_t)0);
+
+        for (size_t b = 0; b < CELLS; b = NEXT_BLKI(b)) {
+            const size_t b_size = GET_SIZE(GET(b));
+            if (!GET_ALLOC(GET(b)) && asize <= b_size && b_size < bb_size) {
+                bb = b;
+                bb_size = b_size;
+            }
+        }
+        return bb;
+    }
+}
+
+/**
+ * stalloc_t::place()
+ *
+ * Sets the header and footer of the allotted block and leftover
+ * block (when applicable) to complete allocation. A leftover of at
+ * least MIN_CELLS cells forms a block of its own, smaller ones stay
+ * in the allotted block.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F>
+constexpr void stalloc_t<MaxSize, T, F>::place(const size_t b, size_t asize) {
+    const size_t fsize = GET_SIZE(GET(b));
+    const size_t lsize = fsize - asize;
+
+    /* The old footer becomes the leftover block's, write its header */
+    if (lsize >= MIN_CELLS) {
+        PUT(b + asize, PACK(lsize, false));
+        PUT(b + fsize - FTR_CELLS, PACK(lsize, false));
+    } else {
+        asize = fsize;
+    }
+
+    PUT(HDRI(b), PACK(asize, true));
+    PUT(b + asize - FTR_CELLS, PACK(asize, true));
+}
+
+/**
+ * stalloc_t::alloc()
+ *
+ * Public facing allocation subroutine. Attempts to find a free
+ * block of at least size bytes (rounded up to whole cells).
+ * Returns a pointer to its first cell on success. Returns nullptr
+ * on failure.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F>
+constexpr T* stalloc_t<MaxSize, T, F>::alloc(const size_t size) {
+    /* Ignore zero-sized and known-too-large requests */
+    if (!size || size > MaxSize)
+        return nullptr;
+
+    const size_t asize = ALIGN_SIZE(size);
+    const size_t b = find_fit(asize);
+
+    if (b == NONE)
+        return nullptr;
+
+    place(b, asize);
+    return m_data + b + HDR_CELLS;
+}
+
+/**
+ * stalloc_t::free()
+ *
+ * Public facing de-allocation subroutine. Attempts to free the
+ * given block whose pointer is provided by the user. Silently
+ * fails if given an invalid request.
+ *
+ * On success attempts to coalesce adjacent free blocks.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F>
+constexpr void stalloc_t<MaxSize, T, F>::free(T* const bp) {
+    const size_t b = index(bp);
+
+    /* Ignore invalid requests */
+    if (b == NONE)
+        return;
+
+    const size_t size = GET_SIZE(GET(b));
+    PUT(HDRI(b), PACK(size, false));
+    PUT(FTRI(b), PACK(size, false));
+
+    coalesce(b);
+}
+
+/**
+ * stalloc_t::coalesce()
+ *
+ * Attempt to coalesce adjacent free blocks. Tags left inside the
+ * merged block are cleared.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F>
+constexpr void stalloc_t<MaxSize, T, F>::coalesce(const size_t b) {
+    const bool prev = PREV_EXIST(b) && !GET_ALLOC(GET(b - FTR_CELLS));
+    const bool next = NEXT_EXIST(b) && !GET_ALLOC(GET(NEXT_BLKI(b)));
+
+    size_t mb = b;
+    size_t size = GET_SIZE(GET(b));
+
+    if (next) {
+        const size_t nb = NEXT_BLKI(b);
+        size += GET_SIZE(GET(nb));
+        PUT(FTRI(b), 0);
+        PUT(HDRI(nb), 0);
+    }
+    if (prev) {
+        mb = PREV_BLKI(b);
+        size += GET_SIZE(GET(mb));
+        PUT(b - FTR_CELLS, 0);
+        PUT(HDRI(b), 0);
+    }
+    if (!prev && !next)
+        return;
+
+    PUT(HDRI(mb), PACK(size, false));
+    PUT(mb + size - FTR_CELLS, PACK(size, false));
+}
+
+/**
+ * stalloc_t::can_alloc()
+ *
+ * Returns true if alloc(size) would currently succeed, without
+ * allocating.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F>
+constexpr bool stalloc_t<MaxSize, T, F>::can_alloc(const size_t size) const {
+    /* Ignore zero-sized and known-too-large requests */
+    if (!size || size > MaxSize)
+        return false;
+
+    return find_fit(ALIGN_SIZE(size)) != NONE;
+}
+
+/**
+ * stalloc_t::usable_size()
+ *
+ * Returns the number of bytes usable by the caller in the given
+ * allocated block (its payload, tags excluded), which may exceed
+ * the requested size. Returns 0 for invalid blocks.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F>
+constexpr size_t stalloc_t<MaxSize, T, F>::usable_size(const T* const bp) const {
+    const size_t b = index(bp);
+
+    /* Ignore invalid requests */
+    if (b == NONE)
+        return 0;
+
+    return (GET_SIZE(GET(b)) - 2 * HDR_CELLS) * sizeof(T);
+}
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <cassert>
 #include <chrono>
+#include <atomic>
+#include <thread>
 #include "stalloc.hpp"
 
 #define pr_inf "inf[" << __func__ << "]: "
@@ -143,6 +145,373 @@ int main() {
     }
     st.printb();
 
+    /* Allocate eight blocks of mixed size (16B -> 128B) from segregated size-class lists */
+    std::cout << std::endl << pr_inf << "allocating eight mixed size blocks (segregated lists)" << std::endl;
+    stalloc_t<4096, int, stalloc_fit_t::first_fit, stalloc_ord_t::seg_order> sst;
+    int* cbuf[8];
+    for (int idx = 0; idx < 8; idx++) {
+        cbuf[idx] = sst.alloc(16 << (idx % 4));
+        assert(cbuf[idx]);
+    }
+
+    /* Free every second block. Blocks 1 and 5 share the 48B size class */
+    std::cout << pr_inf << "freeing every second block in the eight block array" << std::endl;
+    int* const c5 = cbuf[5];
+    for (int idx = 1; idx < 8; idx += 2) {
+        sst.free(cbuf[idx]);
+        cbuf[idx] = nullptr;
+    }
+    sst.printb();
+
+    /* A small request should be served from its own class (LIFO), not the large tail block */
+    std::cout << std::endl << pr_inf << "re-allocating a 32B block from its size class" << std::endl;
+    i = sst.alloc(8 * sizeof(int));
+    assert(i == c5);
+    cbuf[5] = i;
+    i = nullptr;
+
+    /* Free the rest of the blocks. Merged blocks must be re-filed by size class */
+    std::cout << pr_inf << "freeing the rest of the blocks" << std::endl;
+    for (int idx = 0; idx < 8; idx++) {
+        sst.free(cbuf[idx]);
+        cbuf[idx] = nullptr;
+    }
+    sst.printb();
+
+    std::cout << std::endl << pr_inf << "allocating block of max size (segregated lists)" << std::endl;
+    i = sst.alloc(1016 * sizeof(int));
+    assert(i);
+    sst.free(i);
+    i = nullptr;
+
+    /* Allocate 24B blocks with footer elision. Each block only needs a header, so
+     * it takes 32B instead of 48B: 4080B / 32B => 127 blocks (85 with footers) */
+    std::cout << std::endl << pr_inf << "allocating 24B blocks until full (footer elision)" << std::endl;
+    stalloc_t<4096, int, stalloc_fit_t::first_fit, stalloc_ord_t::addr_order,
+              stalloc_ftr_t::elide_ftrs> est;
+    int* dbuf[128] = {nullptr};
+    int dcnt = 0;
+    for (; dcnt < 128; dcnt++) {
+        if (!(dbuf[dcnt] = est.alloc(6 * sizeof(int))))
+            break;
+        for (int x = 0; x < 6; x++)
+            dbuf[dcnt][x] = dcnt;
+    }
+    std::cout << pr_inf << "allocated " << dcnt << " 24B blocks" << std::endl;
+    assert(dcnt == 127);
+
+    /* Free every second block, then the rest from last to first. Payloads must
+     * be intact since they now extend into where footers used to be */
+    std::cout << pr_inf << "freeing every second block, then the rest from last to first" << std::endl;
+    for (int idx = 1; idx < dcnt; idx += 2) {
+        assert(dbuf[idx][5] == idx);
+        est.free(dbuf[idx]);
+        dbuf[idx] = nullptr;
+    }
+    for (int idx = dcnt - 1; idx >= 0; idx -= 2) {
+        assert(dbuf[idx][5] == idx);
+        est.free(dbuf[idx]);
+        dbuf[idx] = nullptr;
+    }
+    est.printb();
+
+    i = est.alloc(1016 * sizeof(int));
+    assert(i);
+    est.free(i);
+    i = nullptr;
+
+    /* Allocate eight blocks of mixed size (64B -> 512B) with best fit over address order
+     * (size-keyed treap) */
+    std::cout << std::endl << pr_inf << "allocating eight mixed size blocks (best fit treap)" << std::endl;
+    stalloc_t<4096, int, stalloc_fit_t::best_fit, stalloc_ord_t::addr_order> tst;
+    for (int idx = 0; idx < 8; idx++) {
+        cbuf[idx] = tst.alloc(64 << (idx % 4));
+        assert(cbuf[idx]);
+    }
+
+    /* Free every second block. Blocks 1 and 5 are both 144B holes */
+    std::cout << pr_inf << "freeing every second block in the eight block array" << std::endl;
+    int* const t1 = cbuf[1];
+    int* const t5 = cbuf[5];
+    for (int idx = 1; idx < 8; idx += 2) {
+        tst.free(cbuf[idx]);
+        cbuf[idx] = nullptr;
+    }
+    tst.printb();
+
+    /* The smallest fitting holes are taken, lowest address first */
+    std::cout << std::endl << pr_inf << "re-allocating two 100B blocks from the smallest holes" << std::endl;
+    cbuf[1] = tst.alloc(25 * sizeof(int));
+    cbuf[5] = tst.alloc(25 * sizeof(int));
+    assert(cbuf[1] == t1 && cbuf[5] == t5);
+
+    std::cout << pr_inf << "freeing the rest of the blocks" << std::endl;
+    for (int idx = 0; idx < 8; idx++) {
+        tst.free(cbuf[idx]);
+        cbuf[idx] = nullptr;
+    }
+    tst.printb();
+
+    i = tst.alloc(1016 * sizeof(int));
+    assert(i);
+    tst.free(i);
+    i = nullptr;
+
+    /* Allocate 16B blocks with compact (16-bit) tags. A block takes 16B plus a 2B
+     * header and footer: 4092B / 20B => 204 blocks (126 with pointer-sized tags) */
+    std::cout << std::endl << pr_inf << "allocating 16B blocks until full (compact tags)" << std::endl;
+    stalloc_t<4096, int, stalloc_fit_t::first_fit, stalloc_ord_t::lifo_order,
+              stalloc_ftr_t::keep_ftrs, stalloc_tag_t::compact_tags> kst;
+    int* kbuf[256] = {nullptr};
+    int kcnt = 0;
+    for (; kcnt < 256; kcnt++) {
+        if (!(kbuf[kcnt] = kst.alloc(4 * sizeof(int))))
+            break;
+        for (int x = 0; x < 4; x++)
+            kbuf[kcnt][x] = kcnt;
+    }
+    std::cout << pr_inf << "allocated " << kcnt << " 16B blocks" << std::endl;
+    assert(kcnt == 204 && kbuf[1] == kbuf[0] + 5);
+
+    /* Free every second block, hand one back through free_remote(), then free
+     * the rest. Freelist links are 16-bit offsets inside the holes */
+    std::cout << pr_inf << "freeing every second block, then the rest from last to first" << std::endl;
+    for (int idx = 1; idx < kcnt; idx += 2) {
+        assert(kbuf[idx][3] == idx);
+        kst.free(kbuf[idx]);
+        kbuf[idx] = nullptr;
+    }
+    kst.free_remote(kbuf[0]);
+    kbuf[0] = nullptr;
+    for (int idx = kcnt - 2; idx > 0; idx -= 2) {
+        assert(kbuf[idx][3] == idx);
+        kst.free(kbuf[idx]);
+        kbuf[idx] = nullptr;
+    }
+    kst.drain();
+    kst.printb();
+
+    i = kst.alloc(1022 * sizeof(int));
+    assert(i);
+    kst.free(i);
+    i = nullptr;
+
+    /* Deferred coalescing: freed 16B blocks go to a quick list, still tagged as
+     * allocated, and are handed out again last freed first */
+    std::cout << std::endl << pr_inf << "allocating and freeing 16B blocks (deferred coalescing)" << std::endl;
+    stalloc_t<4096, int, stalloc_fit_t::first_fit, stalloc_ord_t::addr_order,
+              stalloc_ftr_t::keep_ftrs, stalloc_tag_t::wide_tags, stalloc_coa_t::lazy_coalesce> lst;
+    for (int idx = 0; idx < 8; idx++) {
+        cbuf[idx] = lst.alloc(4 * sizeof(int));
+        assert(cbuf[idx]);
+    }
+    int* const l2 = cbuf[2];
+    int* const l5 = cbuf[5];
+    lst.free(cbuf[2]);
+    lst.free(cbuf[5]);
+    lst.free(cbuf[5]);
+    lst.printb();
+    assert(lst.alloc(4 * sizeof(int)) == l5 && lst.alloc(4 * sizeof(int)) == l2);
+
+    /* Double frees of quick-listed blocks are ignored, even below the top of their list */
+    lst.free(cbuf[2]);
+    lst.free(cbuf[5]);
+    lst.free(cbuf[2]);
+    lst.free_batch(&cbuf[5], 1);
+    assert(!lst.realloc(cbuf[2], 8 * sizeof(int)));
+    assert(lst.alloc(4 * sizeof(int)) == l5 && lst.alloc(4 * sizeof(int)) == l2);
+
+    /* A request no free block can serve sweeps the quick lists first */
+    std::cout << pr_inf << "freeing all blocks, then allocating block of max size" << std::endl;
+    for (int idx = 0; idx < 8; idx++) {
+        lst.free(cbuf[idx]);
+        cbuf[idx] = nullptr;
+    }
+    i = lst.alloc(1016 * sizeof(int));
+    assert(i);
+    lst.free(i);
+    i = nullptr;
+
+    /* Explicit sweep */
+    j = lst.alloc(4 * sizeof(int));
+    lst.free(j);
+    lst.sweep();
+    lst.printb();
+    assert(lst.alloc(4 * sizeof(int)) == j);
+    lst.free(j);
+    j = nullptr;
+
+    /* External storage: the allocator runs over a caller-supplied buffer */
+    std::cout << std::endl << pr_inf << "allocating from an external 4KB buffer" << std::endl;
+    alignas(16) static unsigned char ebuf[4096];
+    memset(ebuf, 0xAB, sizeof(ebuf));
+    stalloc_t<4096, int, stalloc_fit_t::first_fit, stalloc_ord_t::lifo_order, stalloc_ftr_t::keep_ftrs,
+              stalloc_tag_t::wide_tags, stalloc_coa_t::eager_coalesce, stalloc_mem_t::extern_mem> xst(ebuf);
+    i = xst.alloc(1016 * sizeof(int));
+    assert(i && xst.owns(i) && !xst.owns(cbuf) && (size_t)i - (size_t)ebuf == 16);
+    xst.free(i);
+    i = xst.alloc(4 * sizeof(int));
+    j = xst.alloc(4 * sizeof(int));
+    assert(i && j);
+    xst.free(i);
+    xst.free(j);
+    i = j = nullptr;
+    assert(xst.alloc(1016 * sizeof(int)));
+
+    /* Runtime-sized arenas share their engine with every stalloc_t of the same policies */
+    static_assert(std::is_base_of_v<stalloc_dyn_t<int>, stalloc_t<4096, int>> &&
+                  std::is_base_of_v<stalloc_dyn_t<int>, stalloc_t<65536, int>>);
+
+    std::cout << std::endl << pr_inf << "allocating from runtime-sized arenas" << std::endl;
+    alignas(16) static unsigned char rbuf[16384 + 16];
+    for (size_t len : {4096, 6000, 16384}) {
+        stalloc_dyn_t<int> rst(rbuf, len);
+        assert(rst.size() == (len & ~(size_t)15));
+        i = rst.alloc(rst.size() - 32);
+        assert(i && rst.owns(i) && !rst.alloc(4));
+        rst.free(i);
+        i = nullptr;
+    }
+
+    /* Misaligned buffers are trimmed, buffers too small for a block are left unused */
+    stalloc_dyn_t<int> mst(rbuf + 1, 4096);
+    assert(mst.size() == 4080 && ((size_t)mst.alloc(4) & 15) == 0);
+    stalloc_dyn_t<int> zst(rbuf, 47);
+    assert(zst.size() == 0 && !zst.alloc(4) && !zst.can_alloc(4) && !zst.owns(rbuf));
+    zst.printb();
+
+    /* Hand 65,536 16B blocks to a consumer thread that frees them with free_remote().
+     * Remotely freed blocks are reclaimed by the next alloc() on this thread */
+    std::cout << std::endl << pr_inf << "freeing blocks from a consumer thread (free_remote)" << std::endl;
+    std::atomic<int*> slots[64];
+    for (std::atomic<int*>& slot : slots)
+        slot.store(nullptr);
+
+    std::thread consumer([&st, &slots] {
+        for (int n = 0; n < 65536; n++) {
+            std::atomic<int*>& slot = slots[n % 64];
+            int* p;
+            while (!(p = slot.load(std::memory_order_acquire)))
+                std::this_thread::yield();
+            assert(p[0] == n);
+            slot.store(nullptr, std::memory_order_relaxed);
+            st.free_remote(p);
+        }
+    });
+    for (int n = 0; n < 65536; n++) {
+        std::atomic<int*>& slot = slots[n % 64];
+        while (slot.load(std::memory_order_relaxed))
+            std::this_thread::yield();
+        while (!(i = st.alloc(4 * sizeof(int))))
+            std::this_thread::yield();
+        i[0] = n;
+        slot.store(i, std::memory_order_release);
+    }
+    consumer.join();
+    i = nullptr;
+
+    /* Once drained, all blocks should have coalesced back into one */
+    st.drain();
+    st.printb();
+    i = st.alloc(1016 * sizeof(int));
+    assert(i);
+    st.free(i);
+    i = nullptr;
+
+    /* Fragment the buffer into 63 32B holes. Oversized requests only search the
+     * free list once, then fail in constant time until a larger block is freed */
+    std::cout << std::endl << pr_inf << "fragmenting the buffer into 63 32B holes" << std::endl;
+    for (int idx = 0; idx < 126; idx++)
+        abuf[idx] = st.alloc(4 * sizeof(int));
+    i = st.alloc(8 * sizeof(int));
+    assert(i);
+    for (int idx = 1; idx < 126; idx += 2) {
+        st.free(abuf[idx]);
+        abuf[idx] = nullptr;
+    }
+    assert(st.can_alloc(4 * sizeof(int)));
+    assert(!st.can_alloc(12 * sizeof(int)));
+
+    std::cout << pr_inf << "trying to allocate a 48B block 65,536 times" << std::endl;
+    auto fail_start = std::chrono::high_resolution_clock::now();
+    for (int n = 0; n < 65536; n++) {
+        j = st.alloc(12 * sizeof(int));
+        assert(!j);
+    }
+    auto fail_end = std::chrono::high_resolution_clock::now();
+    std::cout << pr_inf << "failed allocations done ["
+              << std::chrono::duration_cast<std::chrono::microseconds>(fail_end - fail_start).count() / 1e6
+              << "s]" << std::endl;
+
+    /* Freeing a neighbour merges two holes into a block that fits again */
+    st.free(abuf[2]);
+    abuf[2] = nullptr;
+    assert(st.can_alloc(12 * sizeof(int)));
+
+    st.free(i);
+    i = nullptr;
+    for (int idx = 0; idx < 126; idx += 2) {
+        st.free(abuf[idx]);
+        abuf[idx] = nullptr;
+    }
+
+    /* Grow a 16B block in place into the free block following it */
+    std::cout << std::endl << pr_inf << "re-allocating a 16B block to 64B (absorbing next block)" << std::endl;
+    i = st.alloc(4 * sizeof(int));
+    j = st.alloc(4 * sizeof(int));
+    k = st.alloc(4 * sizeof(int));
+    for (int x = 0; x < 4; x++)
+        j[x] = x;
+    st.free(k);
+    k = st.realloc(j, 16 * sizeof(int));
+    assert(k == j && j[3] == 3);
+    st.printb();
+
+    /* Grow into the free block preceding it. Contents are moved down */
+    std::cout << std::endl << pr_inf << "freeing i, re-allocating j to 80B (absorbing previous block)" << std::endl;
+    k = st.alloc(4 * sizeof(int));
+    st.free(i);
+    i = st.realloc(j, 20 * sizeof(int));
+    assert(i && i < j && i[3] == 3);
+    st.printb();
+
+    /* Shrink in place, splitting off the tail */
+    std::cout << std::endl << pr_inf << "re-allocating i to 16B (splitting)" << std::endl;
+    j = st.realloc(i, 4 * sizeof(int));
+    assert(j == i && j[3] == 3);
+    st.printb();
+
+    st.free(j);
+    st.free(k);
+    i = j = k = nullptr;
+
+    /* Allocate cache-line aligned blocks behind a 16B block. Free space before
+     * each aligned block is split off and stays available */
+    std::cout << std::endl << pr_inf << "allocating 64B and 128B aligned blocks (alloc_aligned)" << std::endl;
+    i = st.alloc(4 * sizeof(int));
+    j = st.alloc_aligned(16 * sizeof(int), 64);
+    k = st.alloc_aligned(4 * sizeof(int), 128);
+    assert(j && ((size_t)j & 63) == 0 && k && ((size_t)k & 127) == 0);
+    for (int x = 0; x < 16; x++)
+        j[x] = x;
+    st.printb();
+
+    /* Invalid alignments fail */
+    assert(!st.alloc_aligned(4 * sizeof(int), 48));
+    assert(!st.alloc_aligned(4 * sizeof(int), 8192));
+
+    std::cout << pr_inf << "freeing the aligned blocks" << std::endl;
+    assert(j[15] == 15);
+    st.free(i);
+    st.free(j);
+    st.free(k);
+    i = j = k = nullptr;
+
+    i = st.alloc(1016 * sizeof(int));
+    assert(i);
+    st.free(i);
+    i = nullptr;
+
     /* Allocate and free entire buffer many times */
     std::cout << std::endl << pr_inf << "running performance test (65,536 loops)..." << std::endl;;
     auto start_time = std::chrono::high_resolution_clock::now();
@@ -168,5 +537,46 @@ int main() {
     auto dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
     std::cout << pr_inf << "performance test done [" << dur_time.count() / 1000. << "s]" << std::endl;
 
+    /* Same as above, with the 126 blocks allocated and freed in one batch each */
+    std::cout << std::endl << pr_inf << "running batched performance test (65,536 loops)..." << std::endl;
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int l = 0; l < 65536; l++) {
+        const size_t cnt = st.alloc_batch(4 * sizeof(int), 126, abuf);
+        assert(cnt == 126);
+        i = st.alloc(8 * sizeof(int));
+        assert(i);
+        st.free_batch(abuf, 126);
+        st.free(i);
+        i = nullptr;
+    }
+    end_time = std::chrono::high_resolution_clock::now();
+    dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "batched performance test done [" << dur_time.count() / 1000. << "s]" << std::endl;
+
+    /* Same as the first, with deferred coalescing */
+    std::cout << std::endl << pr_inf << "running deferred coalescing performance test (65,536 loops)..." << std::endl;
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int l = 0; l < 65536; l++) {
+        for (int idx = 0; idx < 126; idx++) {
+            abuf[idx] = lst.alloc(4 * sizeof(int));
+            assert(abuf[idx]);
+        }
+        i = lst.alloc(8 * sizeof(int));
+        assert(i);
+        for (int idx = 1; idx < 126; idx += 2) {
+            lst.free(abuf[idx]);
+            abuf[idx] = nullptr;
+        }
+        lst.free(i);
+        i = nullptr;
+        for (int idx = 124; idx >= 0; idx -= 2) {
+            lst.free(abuf[idx]);
+            abuf[idx] = nullptr;
+        }
+    }
+    end_time = std::chrono::high_resolution_clock::now();
+    dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "deferred coalescing performance test done [" << dur_time.count() / 1000. << "s]" << std::endl;
+
     return 0;
 }
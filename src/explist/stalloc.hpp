@@ -1,32 +1,74 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <functional>
 #include <type_traits>
 
+#include "../region/region.hpp"
+
+#ifdef STALLOC_TRACE
+#include "../trace/trace.hpp"
+#endif
+
+#ifdef STALLOC_STATS
+#include "../stats/stats.hpp"
+#endif
+
 enum stalloc_fit_t { first_fit, best_fit };
-enum stalloc_ord_t { lifo_order, addr_order };
+enum stalloc_ord_t { lifo_order, addr_order, seg_order };
+enum stalloc_ftr_t { keep_ftrs, elide_ftrs };
+enum stalloc_tag_t { wide_tags, compact_tags };
+enum stalloc_coa_t { eager_coalesce, lazy_coalesce };
+enum stalloc_mem_t { inline_mem, extern_mem, mapped_mem };
+
+/**
+ * stalloc_dyn_t
+ *
+ * Explicit list allocator over a buffer whose size is only known at
+ * run time, given to the constructor. This is the engine of every
+ * stalloc_t, which only adds the (fixed size) buffer: all arena sizes
+ * with the same policies share one copy of the code.
+ */
+template<typename T = void, stalloc_fit_t F = stalloc_fit_t::first_fit,
+                            stalloc_ord_t O = stalloc_ord_t::lifo_order,
+                            stalloc_ftr_t L = stalloc_ftr_t::keep_ftrs,
+                            stalloc_tag_t W = stalloc_tag_t::wide_tags,
+                            stalloc_coa_t C = stalloc_coa_t::eager_coalesce,
+                            bool Narrow = false>
+class stalloc_dyn_t {
+    /* Compact tags: headers, footers and freelist links are 32-bit words
+     * (16-bit for Narrow buffers, at most 64 KiB) instead of pointer-sized ones */
+    static constexpr bool COMPACT = (W == stalloc_tag_t::compact_tags);
+
+    /* Boundary tag / freelist link word */
+    using word_t = std::conditional_t<!COMPACT, uintptr_t, std::conditional_t<Narrow, uint16_t, uint32_t>>;
 
-template<size_t MaxSize, typename T = void, stalloc_fit_t F = stalloc_fit_t::first_fit,
-                                            stalloc_ord_t O = stalloc_ord_t::lifo_order>
-class stalloc_t {
     /* Word and double-word sizes, architecture dependant (bytes) */
-    /* Note: On 64-bit architectures, alignment (DSIZE) is 16 bytes */
-    static constexpr size_t WSIZE = sizeof(void*);
+    /* Note: On 64-bit architectures, alignment (DSIZE) is 16 bytes, or 8 (4) with compact tags */
+    static constexpr size_t WSIZE = sizeof(word_t);
     static constexpr size_t DSIZE = 2 * WSIZE;
 
-    /* Pack size and alloc bit into a word for header/footer */
+    /* Largest buffer, whose sizes still fit a tag */
+    static constexpr size_t BUF_MAX = !COMPACT ? (size_t)1 << 48 : Narrow ? 65536 : ((size_t)1 << 32) - DSIZE;
+
+    /* Pack size, alloc bit and previous block alloc bit into a word for header/footer */
     /* Note: size is assumed to be DSIZE aligned */
-    static constexpr uintptr_t PACK(size_t size, bool alloc) { return (size | alloc); }
+    static constexpr uintptr_t PACK(size_t size, bool alloc, bool palloc = false) { return (size | alloc | (palloc << 1)); }
 
     /* Read and write a word at address p */
-    static constexpr uintptr_t GET(void* p) { return *(uintptr_t*)p; }
-    static constexpr void PUT(void* p, uintptr_t v) { *(uintptr_t*)p = v; }
+    static constexpr uintptr_t GET(void* p) { return *(word_t*)p; }
+    static constexpr void PUT(void* p, uintptr_t v) { *(word_t*)p = (word_t)v; }
 
     /* Read size and alloc fields from address p */
     static constexpr size_t GET_SIZE(void* p) { return GET(p) & ~(DSIZE - 1); }
     static constexpr size_t GET_ALLOC(void* p) { return GET(p) & 0x1; }
+    static constexpr bool GET_PALLOC(void* p) { return GET(p) & 0x2; }
 
     /* Get header/footer address from block pointer */
     static constexpr void* HDRP(void* bp) { return (void*)((size_t)bp - WSIZE); }
@@ -40,74 +82,298 @@ class stalloc_t {
     static constexpr bool PREV_EXIST(void* bp) { return GET((void*)((size_t)bp - DSIZE)); }
     static constexpr bool NEXT_EXIST(void* bp) { return GET((void*)((size_t)bp + GET_SIZE(HDRP(bp)) - WSIZE)); }
 
+    /* Footer elision: allocated blocks carry no footer, instead every header
+     * records whether the previous block is allocated (see GET_PALLOC) */
+    static constexpr bool ELIDE = (L == stalloc_ftr_t::elide_ftrs);
+
+    /* Set previous block alloc bit in the header of block bp */
+    static constexpr void SET_PALLOC(void* bp, bool palloc) { PUT(HDRP(bp), (GET(HDRP(bp)) & ~(uintptr_t)0x2) | (palloc << 1)); }
+
+    /* Check if previous block exists and is free */
+    static constexpr bool PREV_FREE(void* bp) { return ELIDE ? !GET_PALLOC(HDRP(bp)) : PREV_EXIST(bp) && !GET_ALLOC(HDRP(PREV_BLKP(bp))); }
+
     /* Calculate offset between two pointers */
     static constexpr size_t OFFSET(void* p, void* b) { return (size_t)p - (size_t)b; }
 
     /* Alignment helpers */
     static constexpr size_t ALIGN_MASK(size_t x, size_t m) { return (x + m) & (~m); }
     static constexpr size_t ALIGN_UP(size_t x) { return ALIGN_MASK(x, DSIZE-1); }
-    static constexpr size_t ALIGN_SIZE(size_t x) { return (x > DSIZE) ? ALIGN_UP(x) + DSIZE : 2 * DSIZE; }
+    static constexpr size_t ALIGN_SIZE(size_t x) { return ELIDE ? ((x > DSIZE + WSIZE) ? ALIGN_UP(x + WSIZE) : 2 * DSIZE)
+                                                               : ((x > DSIZE) ? ALIGN_UP(x) + DSIZE : 2 * DSIZE); }
+
+    /* Freelist size classes. With segregated ordering, blocks smaller than
+     * SEG_SMALL get one class per DSIZE multiple (starting at the minimum
+     * block size), larger blocks one class per power of two. Otherwise
+     * there is a single class */
+    static constexpr bool SEG = (O == stalloc_ord_t::seg_order);
+    static constexpr size_t SEG_SMALL = 16 * DSIZE;
+    static constexpr size_t SEG_EXACT = SEG_SMALL / DSIZE - 2;
+    static constexpr size_t FL_INDEX(size_t size) { return !SEG ? 0 : (size < SEG_SMALL) ? size / DSIZE - 2
+                                                                  : SEG_EXACT + std::bit_width(size) - std::bit_width(SEG_SMALL); }
+    static constexpr size_t FL_COUNT = FL_INDEX(BUF_MAX) + 1;
+
+    /* Deferred coalescing: freed blocks smaller than SEG_SMALL are kept,
+     * still tagged allocated, in size-exact LIFO quick lists. They are
+     * released (and coalesced) together by sweep(), which runs when a
+     * search misses or when quick lists hold more than half the buffer */
+    static constexpr bool LAZY = (C == stalloc_coa_t::lazy_coalesce);
+    static constexpr size_t QL_INDEX(size_t size) { return size / DSIZE - 2; }
+    static constexpr size_t QL_COUNT = LAZY ? QL_INDEX(SEG_SMALL) : 1;
+
+    /* Quick-listed blocks are marked with a spare header bit, below DSIZE
+     * and above the alloc and previous alloc bits, to reject double frees */
+    static constexpr uintptr_t QL_BIT = 0x4;
+    static constexpr bool GET_QUICK(void* p) { return LAZY && (GET(p) & QL_BIT); }
+    static constexpr void SET_QUICK(void* bp, bool quick) { PUT(HDRP(bp), (GET(HDRP(bp)) & ~QL_BIT) | (quick ? QL_BIT : 0)); }
 
     /* Ensure T is a trivially copyable type (or void) */
     static_assert(std::is_trivially_copyable_v<T> || std::is_void_v<T>);
 
-    /* Ensure MaxSize is double-word aligned and can fit at least one block */
-    static_assert(((MaxSize & (DSIZE-1)) == 0) && (MaxSize >= 3 * DSIZE));
+    /* Ensure blocks are aligned for T (compact tags only align to 8 or 4 bytes) */
+    static_assert(alignof(std::conditional_t<std::is_void_v<T>, char, T>) <= DSIZE);
+
+    /* Ensure size classes fit the freelist bitmap */
+    static_assert(FL_COUNT <= 64);
+
+    /* Ensure headers have a spare bit to mark quick-listed blocks (not with Narrow compact tags) */
+    static_assert(!LAZY || QL_BIT < DSIZE);
+
+    /* Best fit with address ordering keeps free blocks in a treap (Cartesian
+     * tree) keyed by (size, address) instead of a list, rooted at m_flists[0].
+     * Node priorities are a hash of the block address, so a node needs no
+     * more than the two child pointers that fit the minimum block payload */
+    static constexpr bool TREE = (F == stalloc_fit_t::best_fit && O == stalloc_ord_t::addr_order);
 
-    /* Best fit with address ordering is pointless -- disallow */
-    static_assert(!(F == stalloc_fit_t::best_fit && O == stalloc_ord_t::addr_order),
-            "stalloc_fit_t::best_fit with stalloc_ord_t::addr_order not allowed");
+    struct fl_t;
 
-    /* Freelist type for explicit free linked list */
+    /* Compact freelist link: a signed distance in DSIZE granules from the
+     * granule holding the link itself (0 for nullptr). Being self-relative,
+     * links need no base address and read and assign like plain pointers */
+    struct fl_link_t {
+        using off_t = std::make_signed_t<word_t>;
+        word_t off;
+
+        intptr_t base() const { return (intptr_t)this & ~(intptr_t)(DSIZE - 1); }
+
+        fl_link_t() = default;
+        fl_link_t(const fl_link_t&) = delete;
+
+        operator fl_t*() const { return off ? (fl_t*)(base() + (intptr_t)(off_t)off * (intptr_t)DSIZE) : nullptr; }
+        fl_t* operator->() const { return *this; }
+
+        fl_link_t& operator=(fl_t* const p) {
+            off = p ? (word_t)(((intptr_t)p - base()) / (intptr_t)DSIZE) : 0;
+            return *this;
+        }
+        fl_link_t& operator=(const fl_link_t& l) { return *this = (fl_t*)l; }
+    };
+    using fl_ptr_t = std::conditional_t<COMPACT, fl_link_t, fl_t*>;
+
+    /* Freelist type for explicit free linked list. In a treap, prev and
+     * next are the left (smaller key) and right (larger key) children */
     struct fl_t {
-        fl_t* prev;
-        fl_t* next;
+        fl_ptr_t prev;
+        fl_ptr_t next;
     };
 
+    /* Treap key order and node priority */
+    static constexpr bool TR_LESS(fl_t* a, fl_t* b) { return GET_SIZE(HDRP(a)) < GET_SIZE(HDRP(b)) ||
+                                                             (GET_SIZE(HDRP(a)) == GET_SIZE(HDRP(b)) && a < b); }
+    static constexpr uint64_t TR_PRIO(fl_t* n) { return (uint64_t)(size_t)n * 0x9e3779b97f4a7c15; }
+
     private:
-        unsigned char m_data[MaxSize] = {0};
+        unsigned char* const m_data;
+        const size_t m_size;
         void* const m_listp = m_data + DSIZE;
-        fl_t* m_flistp = (fl_t*)(m_data + DSIZE);
+        std::atomic<void*> m_rfreep = nullptr;
+        fl_ptr_t m_flists[FL_COUNT] = {};
+        uint64_t m_flmap = 0;
+        fl_ptr_t m_qlists[QL_COUNT] = {};
+        size_t m_qbytes = 0;
+
+#ifdef STALLOC_TRACE
+        stalloc_trace_t* m_trace = nullptr;
+
+        void trace_rec(const stalloc_op_t op, void* const bp, const size_t size) {
+            if (m_trace)
+                m_trace->record(op, bp ? (uint32_t)((size_t)bp - (size_t)m_data) : stalloc_trace_t::NO_HANDLE,
+                                (uint32_t)size);
+        }
+#endif
+
+#ifdef STALLOC_STATS
+        stalloc_stats_t m_stats;
+        bool m_stale = false;
+#endif
+
+        /* Upper bound on the largest free block (see find_fit()) */
+        size_t m_maxfree = 0;
+
+        /* Free block bookkeeping, called as free blocks are created (st_add)
+         * and destroyed (st_sub). Only m_maxfree is kept unless STALLOC_STATS
+         * is defined. The largest free block in statistics is only an upper
+         * bound (stale) once a block of its size has been destroyed, until
+         * stats() reads it back from the freelists or a block at least as
+         * large is created */
+        void st_add(const size_t size) {
+            m_maxfree = (size > m_maxfree) ? size : m_maxfree;
+#ifdef STALLOC_STATS
+            m_stats.free_bytes += size;
+            m_stats.free_blocks++;
+            m_stats.classes[stalloc_stats_t::CLASS(size)]++;
+            m_stale &= (size < m_stats.largest);
+            m_stats.largest = (size > m_stats.largest) ? size : m_stats.largest;
+#endif
+        }
+        void st_sub([[maybe_unused]] const size_t size) {
+#ifdef STALLOC_STATS
+            m_stats.free_bytes -= size;
+            m_stats.free_blocks--;
+            m_stats.classes[stalloc_stats_t::CLASS(size)]--;
+            m_stale |= (size == m_stats.largest);
+#endif
+        }
+        void st_peak() {
+#ifdef STALLOC_STATS
+            m_stats.used = m_size - DSIZE - m_stats.free_bytes;
+            m_stats.peak = (m_stats.used > m_stats.peak) ? m_stats.used : m_stats.peak;
+#endif
+        }
+        void st_alloc([[maybe_unused]] const void* const bp, [[maybe_unused]] const size_t n = 1) {
+#ifdef STALLOC_STATS
+            if (bp) {
+                m_stats.allocs += n;
+                st_peak();
+            } else {
+                m_stats.fails++;
+            }
+#endif
+        }
+        void st_free() {
+#ifdef STALLOC_STATS
+            m_stats.frees++;
+#endif
+        }
 
         void* find_fit(const size_t asize);
         void place(void* const bp, size_t asize);
         void coalesce(void* const bp);
+        void split(void* const bp, const size_t asize);
+        void release(void* const bp);
 
         void fl_insert(void* const bp);
         void fl_remove(void* const bp);
 
+        void ql_push(void* const bp);
+        void* ql_pop(const size_t asize);
+
+        /* Failed search: with deferred coalescing, sweep and search again */
+        void* fit_miss(const size_t asize) {
+            if constexpr (LAZY) {
+                if (m_qbytes) {
+                    sweep();
+                    return find_fit(asize);
+                }
+            }
+            return nullptr;
+        }
+
+        /* Usable length of a buffer once its start is aligned up to DSIZE
+         * and its length down to a multiple of DSIZE. Zero if it cannot fit
+         * a block, or a size would not fit a tag */
+        static size_t BUF_SIZE(void* const buf, const size_t len) {
+            const size_t pad = ALIGN_UP((size_t)buf) - (size_t)buf;
+            const size_t size = (buf && len > pad) ? (len - pad) & ~(DSIZE - 1) : 0;
+            return (size >= 3 * DSIZE && size <= BUF_MAX) ? size : 0;
+        }
+
     public:
-        stalloc_t() {
+        /* Block alignment and largest buffer (bytes) */
+        static constexpr size_t ALIGNMENT = DSIZE;
+        static constexpr size_t MAX_SIZE = BUF_MAX;
+
+        /* Headers of allocated blocks are rewritten as their neighbours change */
+        static constexpr bool ELIDE_FTRS = ELIDE;
+
+        /* Allocator over len bytes at buf, which must outlive it. Without
+         * room for a block every allocation fails (see BUF_SIZE) */
+        stalloc_dyn_t(void* const buf, const size_t len)
+            : m_data((unsigned char*)ALIGN_UP((size_t)buf)), m_size(BUF_SIZE(buf, len)) {
+            if (!m_size)
+                return;
+
             /* First and last words are reserved */
-            PUT(m_data + WSIZE, PACK(MaxSize - DSIZE, false));
-            PUT(FTRP(m_data + DSIZE), PACK(MaxSize - DSIZE, false));
+            PUT(m_data, 0);
+            PUT(m_data + m_size - WSIZE, 0);
+            PUT(m_data + WSIZE, PACK(m_size - DSIZE, false, ELIDE));
+            PUT(FTRP(m_data + DSIZE), PACK(m_size - DSIZE, false));
 
             /* Freelist starts as a single node */
-            m_flistp->prev = nullptr;
-            m_flistp->next = nullptr;
-        };
+            fl_insert(m_listp);
+
+            st_add(m_size - DSIZE);
+        }
 
         [[nodiscard]] T* alloc(const size_t size);
+        [[nodiscard]] T* alloc_aligned(const size_t size, const size_t align);
         void free(T* const bp);
+        [[nodiscard]] T* realloc(T* const bp, const size_t size);
+        [[nodiscard]] size_t usable_size(T* const bp);
+        [[nodiscard]] bool can_alloc(const size_t size);
+
+        /* Batched allocation/de-allocation of many blocks at once */
+        [[nodiscard]] size_t alloc_batch(const size_t size, const size_t n, T** const out);
+        void free_batch(T** const ptrs, const size_t n);
+
+        /* Cross-thread de-allocation */
+        void free_remote(T* const bp);
+        void drain();
+
+        /* Release and coalesce all quick-listed blocks (deferred coalescing) */
+        void sweep();
+
+#ifdef STALLOC_STATS
+        /* Allocator statistics (see stalloc_stats_t) */
+        const stalloc_stats_t& stats();
+#endif
+
+#ifdef STALLOC_TRACE
+        /* Attach (or detach, given nullptr) an allocation trace recorder */
+        void trace(stalloc_trace_t* const tr) {
+            m_trace = tr;
+            if (tr)
+                tr->attach(m_size);
+        }
+#endif
+
+        /* Check if a block lies within the buffer */
+        bool owns(const void* const p) const { return (size_t)p - (size_t)m_data < m_size; }
+
+        /* Usable buffer size (bytes), 0 if the buffer could not fit a block */
+        size_t size() const { return m_size; }
 
         /* Debug */
         void printb();
 };
 
 /**
- * stalloc_t::printb()
+ * stalloc_dyn_t::printb()
  *
  * Print a formatted representation of the instantiated stack
  * allocator's block list.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ord_t O>
-void stalloc_t<MaxSize, T, F, O>::printb() {
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::printb() {
     printf("+------------------------------------------------+\n"
            "|                      Stack                     |\n"
            "+-------+----------------+--------------+--------+\n"
            "| Block |     Address    |     Size     | Status |\n"
            "+-------+----------------+--------------+--------+\n");
 
+    /* No block list without a buffer (see BUF_SIZE) */
+    if (!m_size)
+        return;
+
     int i = 0;
     for (void* bp = m_listp; GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp), i++) {
         printf("| %-6d| %p | %-13ld|   %c    |\n"
@@ -117,48 +383,82 @@ void stalloc_t<MaxSize, T, F, O>::printb() {
 }
 
 /**
- * stalloc_t::fl_insert()
+ * stalloc_dyn_t::fl_insert()
  *
  * Insert block into freelist.
  *
  * Order algorithm may be chosen at compile time/instantiation
  * via the stalloc_ord_t type template parameter. Defaults to
- * stalloc_ord_t::lifo_order.
+ * stalloc_ord_t::lifo_order. With stalloc_ord_t::seg_order the
+ * block is LIFO inserted into the list of its size class. With
+ * stalloc_fit_t::best_fit and stalloc_ord_t::addr_order the block
+ * is inserted into the size-keyed treap in O(log n) expected time.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ord_t O>
-void stalloc_t<MaxSize, T, F, O>::fl_insert(void* const bp) {
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::fl_insert(void* const bp) {
     fl_t* const fbp = static_cast<fl_t*>(bp);
 
     /* Ignore invalid requests */
     if (!fbp)
         return;
 
+    /* Treap: descend to the first node of lower priority, split its
+     * subtree around fbp and put fbp in its place */
+    if constexpr (TREE) {
+        fl_ptr_t* link = &m_flists[0];
+        while (*link && TR_PRIO(*link) > TR_PRIO(fbp))
+            link = TR_LESS(fbp, *link) ? &(*link)->prev : &(*link)->next;
+
+        fl_ptr_t* l = &fbp->prev;
+        fl_ptr_t* r = &fbp->next;
+        for (fl_t* flp = *link; flp;) {
+            if (TR_LESS(flp, fbp)) {
+                *l = flp;
+                l = &flp->next;
+                flp = flp->next;
+            } else {
+                *r = flp;
+                r = &flp->prev;
+                flp = flp->prev;
+            }
+        }
+        *l = *r = nullptr;
+        *link = fbp;
+        return;
+    }
+
+    const size_t idx = FL_INDEX(GET_SIZE(HDRP(bp)));
+    fl_ptr_t& flistp = m_flists[idx];
+
+    if constexpr (SEG)
+        m_flmap |= (uint64_t)1 << idx;
+
     /* If freelist is empty, fbp is new start of freelist */
-    if (!m_flistp) {
-        m_flistp = fbp;
-        m_flistp->prev = nullptr;
-        m_flistp->next = nullptr;
+    if (!flistp) {
+        flistp = fbp;
+        flistp->prev = nullptr;
+        flistp->next = nullptr;
         return;
     }
 
     /* LIFO Ordering */
-    if constexpr (O == stalloc_ord_t::lifo_order) {
+    if constexpr (O == stalloc_ord_t::lifo_order || O == stalloc_ord_t::seg_order) {
         fbp->prev = nullptr;
-        fbp->next = m_flistp;
-        m_flistp->prev = fbp;
-        m_flistp = fbp;
+        fbp->next = flistp;
+        flistp->prev = fbp;
+        flistp = fbp;
     }
     /* Address Ordering */
     if constexpr (O == stalloc_ord_t::addr_order) {
-        if (fbp < m_flistp) {
+        if (fbp < flistp) {
             fbp->prev = nullptr;
-            fbp->next = m_flistp;
-            m_flistp->prev = fbp;
-            m_flistp = fbp;
+            fbp->next = flistp;
+            flistp->prev = fbp;
+            flistp = fbp;
             return;
         }
 
-        fl_t* flp = m_flistp;
+        fl_t* flp = flistp;
         while (flp->next && flp < fbp)
             flp = flp->next;
 
@@ -176,26 +476,58 @@ void stalloc_t<MaxSize, T, F, O>::fl_insert(void* const bp) {
 }
 
 /**
- * stalloc_t::fl_remove()
+ * stalloc_dyn_t::fl_remove()
  *
- * Remove block from freelist.
+ * Remove block from freelist. The block's header must still
+ * hold the size it was inserted with.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ord_t O>
-void stalloc_t<MaxSize, T, F, O>::fl_remove(void* const bp) {
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::fl_remove(void* const bp) {
     fl_t* const fbp = static_cast<fl_t*>(bp);
 
     /* Ignore invalid requests */
     if (!fbp)
         return;
 
+    /* Treap: descend to the link to fbp and replace it with the merge
+     * of fbp's subtrees (every key on the left is below the right) */
+    if constexpr (TREE) {
+        fl_ptr_t* link = &m_flists[0];
+        while (*link != fbp)
+            link = TR_LESS(fbp, *link) ? &(*link)->prev : &(*link)->next;
+
+        fl_t* l = fbp->prev;
+        fl_t* r = fbp->next;
+        while (l && r) {
+            if (TR_PRIO(l) > TR_PRIO(r)) {
+                *link = l;
+                link = &l->next;
+                l = l->next;
+            } else {
+                *link = r;
+                link = &r->prev;
+                r = r->prev;
+            }
+        }
+        *link = l ? l : r;
+        fbp->prev = nullptr;
+        fbp->next = nullptr;
+        return;
+    }
+
+    const size_t idx = FL_INDEX(GET_SIZE(HDRP(bp)));
+    fl_ptr_t& flistp = m_flists[idx];
+
     /* Only block in freelist */
     if (!fbp->prev && !fbp->next) {
-        m_flistp = nullptr;
+        flistp = nullptr;
+        if constexpr (SEG)
+            m_flmap &= ~((uint64_t)1 << idx);
     }
     /* Located at head of freelist */
     else if (!fbp->prev) {
-        m_flistp = fbp->next;
-        m_flistp->prev = nullptr;
+        flistp = fbp->next;
+        flistp->prev = nullptr;
         fbp->next = nullptr;
     }
     /* Located at tail of freelist */
@@ -213,7 +545,7 @@ void stalloc_t<MaxSize, T, F, O>::fl_remove(void* const bp) {
 }
 
 /**
- * stalloc_t::find_fit()
+ * stalloc_dyn_t::find_fit()
  *
  * Free block fit finder. Returns pointer to the allotted
  * block if fit is found. Otherwise returns nullptr.
@@ -221,67 +553,121 @@ void stalloc_t<MaxSize, T, F, O>::fl_remove(void* const bp) {
  * Fit algorithm may be chosen at compile time/instantiation
  * via the stalloc_fit_t type template parameter. Defaults to
  * stalloc_type_t::first_fit.
+ *
+ * Requests larger than m_maxfree, an upper bound on the largest
+ * free block, fail without searching. The bound is raised as free
+ * blocks are created, and lowered to just below asize whenever a
+ * search fails, so repeated oversized requests fail in constant
+ * time even when the free space is fragmented.
+ *
+ * With stalloc_ord_t::seg_order only the non-empty size classes
+ * at or above that of asize are searched. Any block in a class
+ * above that of asize fits, so a search rarely visits more than
+ * two lists.
+ *
+ * With stalloc_fit_t::best_fit and stalloc_ord_t::addr_order a
+ * single descent of the treap finds the smallest fitting block,
+ * the lowest addressed among equals.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ord_t O>
-void* stalloc_t<MaxSize, T, F, O>::find_fit(const size_t asize) {
-    /* First Fit */
-    if constexpr (F == stalloc_fit_t::first_fit) {
-        for (fl_t* flp = m_flistp; flp; flp = flp->next) {
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void* stalloc_dyn_t<T, F, O, L, W, C, Narrow>::find_fit(const size_t asize) {
+    const size_t idx = FL_INDEX(asize);
+
+    /* Known-too-large request */
+    if (asize > m_maxfree)
+        return fit_miss(asize);
+
+    /* Best Fit (treap) */
+    if constexpr (TREE) {
+        fl_t* bp = nullptr;
+        for (fl_t* flp = m_flists[0]; flp;) {
             if (asize <= GET_SIZE(HDRP(flp))) {
-                return static_cast<void*>(flp);
+                bp = flp;
+                flp = flp->prev;
+            } else {
+                flp = flp->next;
             }
         }
-        return nullptr;
+        if (bp)
+            return static_cast<void*>(bp);
+
+        m_maxfree = asize - DSIZE;
+        return fit_miss(asize);
     }
-    /* Best Fit */
-    if constexpr (F == stalloc_fit_t::best_fit) {
-        fl_t* bp = nullptr;
-        size_t bp_size = ~((size_t)0);
 
-        for (fl_t* flp = m_flistp; flp; flp = flp->next) {
-            const size_t flp_size = GET_SIZE(HDRP(flp));
-            if (asize <= flp_size && flp_size < bp_size) {
-                bp = flp;
-                bp_size = flp_size;
+    for (uint64_t map = SEG ? (m_flmap >> idx) << idx : 1; map; map &= map - 1) {
+        fl_t* const flistp = m_flists[std::countr_zero(map)];
+
+        /* First Fit */
+        if constexpr (F == stalloc_fit_t::first_fit) {
+            for (fl_t* flp = flistp; flp; flp = flp->next) {
+                if (asize <= GET_SIZE(HDRP(flp))) {
+                    return static_cast<void*>(flp);
+                }
             }
         }
-        return static_cast<void*>(bp);
+        /* Best Fit */
+        if constexpr (F == stalloc_fit_t::best_fit) {
+            fl_t* bp = nullptr;
+            size_t bp_size = ~((size_t)0);
+
+            for (fl_t* flp = flistp; flp; flp = flp->next) {
+                const size_t flp_size = GET_SIZE(HDRP(flp));
+                if (asize <= flp_size && flp_size < bp_size) {
+                    bp = flp;
+                    bp_size = flp_size;
+                }
+            }
+            if (bp)
+                return static_cast<void*>(bp);
+        }
     }
+
+    m_maxfree = asize - DSIZE;
+    return fit_miss(asize);
 }
 
 /**
- * stalloc_t::place()
+ * stalloc_dyn_t::place()
  *
  * Sets the header and footer of the allotted block and leftover
  * block (when applicable) to (total_size | 1) to complete allocation.
  * The size placed in the header/footer includes that of the header and
  * footer themselves.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ord_t O>
-void stalloc_t<MaxSize, T, F, O>::place(void* const bp, size_t asize) {
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::place(void* const bp, size_t asize) {
     /* Get current (free) block size and leftover block size */
     const size_t fsize = GET_SIZE(HDRP(bp));
     const size_t lsize = fsize - asize;
+    const bool palloc = GET_PALLOC(HDRP(bp));
+
+    st_sub(fsize);
 
     /* If leftover size is too small for another block, use all of free
      * block size. Otherwise set leftover block size accordingly */
     if (lsize < 2 * DSIZE) {
         asize = fsize;
     } else {
-        PUT(HDRP((void*)((size_t)bp + asize)), PACK(lsize, false));
+        PUT(HDRP((void*)((size_t)bp + asize)), PACK(lsize, false, ELIDE));
         PUT(FTRP((void*)((size_t)bp + asize)), PACK(lsize, false));
+        st_add(lsize);
         fl_insert((void*)((size_t)bp + asize));
     }
 
     fl_remove(bp);
 
-    /* Write header and footer for newly allocated block */
-    PUT(HDRP(bp), PACK(asize, true));
-    PUT(FTRP(bp), PACK(asize, true));
+    /* Write header and footer for newly allocated block. With footer
+     * elision the next block records the allocation instead */
+    PUT(HDRP(bp), PACK(asize, true, palloc));
+    if constexpr (!ELIDE)
+        PUT(FTRP(bp), PACK(asize, true));
+    else if (NEXT_EXIST(bp))
+        SET_PALLOC(NEXT_BLKP(bp), true);
 }
 
 /**
- * stalloc_t::alloc()
+ * stalloc_dyn_t::alloc()
  *
  * Public facing allocation subroutine. Attempts to find a free
  * block of adequate size for the request. Returns a pointer to
@@ -296,56 +682,589 @@ void stalloc_t<MaxSize, T, F, O>::place(void* const bp, size_t asize) {
  * The start address of the newly allotted block is always double-
  * word aligned, as is the size of the block.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ord_t O>
-T* stalloc_t<MaxSize, T, F, O>::alloc(const size_t size) {
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+T* stalloc_dyn_t<T, F, O, L, W, C, Narrow>::alloc(const size_t size) {
     /* Ignore zero-sized and known-too-large requests */
-    if (!size || size > MaxSize - (2 * DSIZE))
+    if (!size || size > m_size - (2 * DSIZE))
         return nullptr;
 
+    /* Reclaim blocks freed by other threads */
+    drain();
+
     void* bp = nullptr;
     const size_t asize = ALIGN_SIZE(size);
 
-    if ((bp = find_fit(asize)))
+    if constexpr (LAZY)
+        bp = ql_pop(asize);
+
+    if (!bp && (bp = find_fit(asize)))
         place(bp, asize);
 
+    st_alloc(bp);
+
+#ifdef STALLOC_TRACE
+    trace_rec(alloc_op, bp, size);
+#endif
+
     return static_cast<T*>(bp);
 }
 
 /**
- * stalloc_t::free()
+ * stalloc_dyn_t::alloc_aligned()
+ *
+ * Aligned allocation subroutine, see the implicit list's
+ * stalloc_t::alloc_aligned(). With stalloc_tag_t::compact_tags blocks
+ * are only 8B (4B) aligned, so any larger alignment takes the slack
+ * search.
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+T* stalloc_dyn_t<T, F, O, L, W, C, Narrow>::alloc_aligned(const size_t size, const size_t align) {
+    /* Ignore invalid alignments, zero-sized and known-too-large requests */
+    if (!align || (align & (align - 1)) || !size || size > m_size - (2 * DSIZE) || align > m_size)
+        return nullptr;
+
+    /* Every block is DSIZE aligned */
+    if (align <= DSIZE)
+        return alloc(size);
+
+    /* Reclaim blocks freed by other threads */
+    drain();
+
+    const size_t asize = ALIGN_SIZE(size);
+    void* bp = find_fit(asize + align + DSIZE);
+
+    /* Split off the free space before the aligned address */
+    size_t gap = bp ? (align - ((size_t)bp & (align - 1))) & (align - 1) : 0;
+    if (gap == DSIZE)
+        gap += align;
+    if (gap) {
+        const size_t fsize = GET_SIZE(HDRP(bp));
+        const bool palloc = GET_PALLOC(HDRP(bp));
+        void* const abp = (void*)((size_t)bp + gap);
+
+        fl_remove(bp);
+        st_sub(fsize);
+        PUT(HDRP(bp), PACK(gap, false, palloc));
+        PUT(FTRP(bp), PACK(gap, false));
+        PUT(HDRP(abp), PACK(fsize - gap, false));
+        PUT(FTRP(abp), PACK(fsize - gap, false));
+        st_add(gap);
+        st_add(fsize - gap);
+        fl_insert(bp);
+        fl_insert(abp);
+
+        bp = abp;
+    }
+
+    if (bp)
+        place(bp, asize);
+
+    st_alloc(bp);
+
+#ifdef STALLOC_TRACE
+    trace_rec(alloc_op, bp, size);
+#endif
+
+    return static_cast<T*>(bp);
+}
+
+/**
+ * stalloc_dyn_t::free()
  *
  * Public facing de-allocation subroutine. Attempts to free the
  * given block whose pointer is provided by the user. Silently
  * fails if given an invalid request.
  *
- * On success attempts to coalesce adjacent free blocks.
+ * On success attempts to coalesce adjacent free blocks. With
+ * stalloc_coa_t::lazy_coalesce, blocks smaller than SEG_SMALL are
+ * instead pushed onto a quick list (see ql_push()).
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ord_t O>
-void stalloc_t<MaxSize, T, F, O>::free(T* const bp) {
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::free(T* const bp) {
+    void* const vbp = static_cast<void*>(bp);
+
+    /* Ignore invalid requests, and blocks already on a quick list */
+    if (!vbp || !GET_ALLOC(HDRP(vbp)) || GET_QUICK(HDRP(vbp)))
+        return;
+
+#ifdef STALLOC_TRACE
+    trace_rec(free_op, vbp, 0);
+#endif
+
+    st_free();
+
+    if constexpr (LAZY) {
+        if (GET_SIZE(HDRP(vbp)) < SEG_SMALL) {
+            ql_push(vbp);
+            return;
+        }
+    }
+
+    release(vbp);
+}
+
+/**
+ * stalloc_dyn_t::release()
+ *
+ * Free an allocated block and coalesce it with adjacent free
+ * blocks. Shared by free(), free_batch() and split(), which have
+ * already validated the block.
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::release(void* const bp) {
+    const size_t size = GET_SIZE(HDRP(bp));
+    PUT(HDRP(bp), PACK(size, false, GET_PALLOC(HDRP(bp))));
+    PUT(FTRP(bp), PACK(size, false));
+    st_add(size);
+
+    if constexpr (ELIDE) {
+        if (NEXT_EXIST(bp))
+            SET_PALLOC(NEXT_BLKP(bp), false);
+    }
+
+    fl_insert(bp);
+    coalesce(bp);
+}
+
+/**
+ * stalloc_dyn_t::free_remote()
+ *
+ * De-allocation subroutine for threads other than the one owning
+ * the allocator. The block is pushed onto a lock-free queue of
+ * remotely freed blocks, linked through the first word of each
+ * block's payload. The owning thread frees queued blocks in
+ * drain(), which alloc() also calls on entry.
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::free_remote(T* const bp) {
     void* const vbp = static_cast<void*>(bp);
 
     /* Ignore invalid requests */
-    if (!vbp || !GET_ALLOC(HDRP(vbp)))
+    if (!vbp)
+        return;
+
+    void* head = m_rfreep.load(std::memory_order_relaxed);
+    do {
+        static_cast<fl_t*>(vbp)->prev = static_cast<fl_t*>(head);
+    } while (!m_rfreep.compare_exchange_weak(head, vbp, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+}
+
+/**
+ * stalloc_dyn_t::drain()
+ *
+ * Free all blocks queued by free_remote(). Must only be called by
+ * the thread owning the allocator. The whole queue is detached
+ * in one exchange, so this costs a single plain load when the
+ * queue is empty.
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::drain() {
+    if (!m_rfreep.load(std::memory_order_relaxed))
+        return;
+
+    void* bp = m_rfreep.exchange(nullptr, std::memory_order_acquire);
+    while (bp) {
+        void* const next = static_cast<fl_t*>(bp)->prev;
+        free(static_cast<T*>(bp));
+        bp = next;
+    }
+}
+
+/**
+ * stalloc_dyn_t::ql_push()
+ *
+ * Defer the de-allocation of a small block by pushing it onto the
+ * quick list of its exact size. The block keeps its allocated tags,
+ * so neither coalescing nor realloc() touches it, and is linked
+ * through the first word of its payload, and marked with QL_BIT
+ * so that free() rejects it until it is popped or swept.
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::ql_push(void* const bp) {
+    const size_t size = GET_SIZE(HDRP(bp));
+    fl_ptr_t& qlistp = m_qlists[QL_INDEX(size)];
+
+    SET_QUICK(bp, true);
+    static_cast<fl_t*>(bp)->prev = qlistp;
+    qlistp = static_cast<fl_t*>(bp);
+
+    m_qbytes += size;
+    if (m_qbytes > m_size / 2)
+        sweep();
+}
+
+/**
+ * stalloc_dyn_t::ql_pop()
+ *
+ * Take a block of exactly asize bytes off its quick list. Returns
+ * nullptr if there is none.
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void* stalloc_dyn_t<T, F, O, L, W, C, Narrow>::ql_pop(const size_t asize) {
+    if (asize >= SEG_SMALL)
+        return nullptr;
+
+    fl_ptr_t& qlistp = m_qlists[QL_INDEX(asize)];
+    fl_t* const bp = qlistp;
+
+    if (bp) {
+        qlistp = bp->prev;
+        m_qbytes -= asize;
+        SET_QUICK(bp, false);
+    }
+    return static_cast<void*>(bp);
+}
+
+/**
+ * stalloc_dyn_t::sweep()
+ *
+ * Release all quick-listed blocks, coalescing them with adjacent
+ * free blocks. Called on a failed search and when quick lists grow
+ * past half the buffer, and may be called at any time (e.g. when
+ * idle). Does nothing without stalloc_coa_t::lazy_coalesce.
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::sweep() {
+    if constexpr (LAZY) {
+        for (size_t idx = 0; idx < QL_COUNT; idx++) {
+            fl_t* bp = m_qlists[idx];
+            m_qlists[idx] = nullptr;
+
+            while (bp) {
+                fl_t* const next = bp->prev;
+                release(static_cast<void*>(bp));
+                bp = next;
+            }
+        }
+        m_qbytes = 0;
+    }
+}
+
+/**
+ * stalloc_dyn_t::split()
+ *
+ * Shrink an allocated block to asize, freeing its tail (and
+ * coalescing it with the following block) when the tail is large
+ * enough to form another block.
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::split(void* const bp, const size_t asize) {
+    const size_t size = GET_SIZE(HDRP(bp));
+
+    if (size - asize < 2 * DSIZE)
+        return;
+
+    void* const tbp = (void*)((size_t)bp + asize);
+
+    PUT(HDRP(bp), PACK(asize, true, GET_PALLOC(HDRP(bp))));
+    if constexpr (!ELIDE)
+        PUT(FTRP(bp), PACK(asize, true));
+
+    PUT(HDRP(tbp), PACK(size - asize, true, ELIDE));
+    if constexpr (!ELIDE)
+        PUT(FTRP(tbp), PACK(size - asize, true));
+
+    release(tbp);
+}
+
+/**
+ * stalloc_dyn_t::realloc()
+ *
+ * Public facing re-allocation subroutine, see the implicit list's
+ * stalloc_t::realloc(). Absorbed neighbours are unlinked from their
+ * freelist (or the treap, in O(log n) expected time), and the tail
+ * split off is inserted as any other free block.
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+T* stalloc_dyn_t<T, F, O, L, W, C, Narrow>::realloc(T* const bp, const size_t size) {
+    void* const vbp = static_cast<void*>(bp);
+
+    if (!vbp)
+        return alloc(size);
+
+    if (!size) {
+        free(bp);
+        return nullptr;
+    }
+
+    /* Ignore invalid and known-too-large requests */
+    if (!GET_ALLOC(HDRP(vbp)) || GET_QUICK(HDRP(vbp)) || size > m_size - (2 * DSIZE))
+        return nullptr;
+
+    const size_t asize = ALIGN_SIZE(size);
+    const size_t csize = GET_SIZE(HDRP(vbp));
+
+    /* Shrink in place */
+    if (asize <= csize) {
+        split(vbp, asize);
+#ifdef STALLOC_TRACE
+        trace_rec(free_op, vbp, 0);
+        trace_rec(alloc_op, vbp, size);
+#endif
+        return bp;
+    }
+
+    void* const nbp = NEXT_BLKP(vbp);
+    const size_t nsize = (NEXT_EXIST(vbp) && !GET_ALLOC(HDRP(nbp))) ? GET_SIZE(HDRP(nbp)) : 0;
+    const bool palloc = GET_PALLOC(HDRP(vbp));
+
+    /* Grow in place into the following free block */
+    if (csize + nsize >= asize) {
+        st_sub(nsize);
+        fl_remove(nbp);
+        PUT(HDRP(vbp), PACK(csize + nsize, true, palloc));
+        if constexpr (!ELIDE)
+            PUT(FTRP(vbp), PACK(csize + nsize, true));
+        else if (NEXT_EXIST(vbp))
+            SET_PALLOC(NEXT_BLKP(vbp), true);
+
+        split(vbp, asize);
+        st_peak();
+#ifdef STALLOC_TRACE
+        trace_rec(free_op, vbp, 0);
+        trace_rec(alloc_op, vbp, size);
+#endif
+        return bp;
+    }
+
+    /* Grow into the preceding (and following) free block, moving contents down */
+    if (PREV_FREE(vbp)) {
+        void* const pbp = PREV_BLKP(vbp);
+        const size_t tsize = GET_SIZE(HDRP(pbp)) + csize + nsize;
+
+        if (tsize >= asize) {
+            st_sub(GET_SIZE(HDRP(pbp)));
+            if (nsize)
+                st_sub(nsize);
+            const bool ppalloc = GET_PALLOC(HDRP(pbp));
+            fl_remove(pbp);
+            if (nsize)
+                fl_remove(nbp);
+
+            memmove(pbp, vbp, csize - (ELIDE ? WSIZE : DSIZE));
+            PUT(HDRP(pbp), PACK(tsize, true, ppalloc));
+            if constexpr (!ELIDE)
+                PUT(FTRP(pbp), PACK(tsize, true));
+            else if (NEXT_EXIST(pbp))
+                SET_PALLOC(NEXT_BLKP(pbp), true);
+
+            split(pbp, asize);
+            st_peak();
+#ifdef STALLOC_TRACE
+            trace_rec(free_op, vbp, 0);
+            trace_rec(alloc_op, pbp, size);
+#endif
+            return static_cast<T*>(pbp);
+        }
+    }
+
+    /* Fall back to allocate, copy and free */
+    T* const rbp = alloc(size);
+    if (rbp) {
+        memcpy(static_cast<void*>(rbp), vbp, csize - (ELIDE ? WSIZE : DSIZE));
+        free(bp);
+    }
+    return rbp;
+}
+
+/**
+ * stalloc_dyn_t::alloc_batch()
+ *
+ * Public facing batch allocation subroutine, see the implicit list's
+ * stalloc_t::alloc_batch(). The contiguous region is searched for
+ * by find_fit() as one request of n * size bytes, so it costs no
+ * more than a single allocation.
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+size_t stalloc_dyn_t<T, F, O, L, W, C, Narrow>::alloc_batch(const size_t size, const size_t n, T** const out) {
+    /* Ignore zero-sized and known-too-large requests */
+    if (!size || !n || !out || size > m_size - (2 * DSIZE))
+        return 0;
+
+    /* Reclaim blocks freed by other threads */
+    drain();
+
+    const size_t asize = ALIGN_SIZE(size);
+    void* bp = nullptr;
+
+    if (n <= m_size / asize && (bp = find_fit(n * asize))) {
+        place(bp, n * asize);
+
+        /* Split the placed region, the last block keeps any leftover */
+        const bool palloc = GET_PALLOC(HDRP(bp));
+        const size_t lsize = GET_SIZE(HDRP(bp)) - (n - 1) * asize;
+
+        for (size_t i = 0; i < n; i++) {
+            void* const cbp = (void*)((size_t)bp + i * asize);
+            const size_t csize = (i == n - 1) ? lsize : asize;
+
+            PUT(HDRP(cbp), PACK(csize, true, i ? ELIDE : palloc));
+            if constexpr (!ELIDE)
+                PUT(FTRP(cbp), PACK(csize, true));
+            out[i] = static_cast<T*>(cbp);
+
+#ifdef STALLOC_TRACE
+            trace_rec(alloc_op, cbp, size);
+#endif
+        }
+
+        st_alloc(bp, n);
+        return n;
+    }
+
+    size_t cnt = 0;
+    while (cnt < n && (out[cnt] = alloc(size)))
+        cnt++;
+    return cnt;
+}
+
+/**
+ * stalloc_dyn_t::free_batch()
+ *
+ * Public facing batch de-allocation subroutine, see the implicit
+ * list's stalloc_t::free_batch(). Merged runs are released directly
+ * into the freelists, bypassing the quick lists of
+ * stalloc_coa_t::lazy_coalesce.
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::free_batch(T** const ptrs, const size_t n) {
+    if (!ptrs)
         return;
 
-    const size_t size = GET_SIZE(HDRP(vbp));
-    PUT(HDRP(vbp), PACK(size, false));
-    PUT(FTRP(vbp), PACK(size, false));
+    std::sort(ptrs, ptrs + n, std::less<T*>());
+
+    void* end = nullptr;
+    for (size_t i = 0; i < n; i++) {
+        void* const vbp = static_cast<void*>(ptrs[i]);
+
+        /* Ignore invalid requests, quick-listed blocks, and blocks already part of a run */
+        if (!vbp || (size_t)vbp < (size_t)end || !GET_ALLOC(HDRP(vbp)) || GET_QUICK(HDRP(vbp)))
+            continue;
+
+#ifdef STALLOC_TRACE
+        trace_rec(free_op, vbp, 0);
+#endif
+        st_free();
+
+        /* Extend the run while the next pointer is the next allocated block */
+        end = NEXT_BLKP(vbp);
+        for (; i + 1 < n && static_cast<void*>(ptrs[i + 1]) == end && GET_ALLOC(HDRP(end)) && !GET_QUICK(HDRP(end)); i++) {
+#ifdef STALLOC_TRACE
+            trace_rec(free_op, end, 0);
+#endif
+            st_free();
+            end = NEXT_BLKP(end);
+        }
+
+        const size_t size = (size_t)end - (size_t)vbp;
+        PUT(HDRP(vbp), PACK(size, true, GET_PALLOC(HDRP(vbp))));
+        if constexpr (!ELIDE)
+            PUT(FTRP(vbp), PACK(size, true));
+
+        release(vbp);
+    }
+}
+
+#ifdef STALLOC_STATS
+/**
+ * stalloc_dyn_t::stats()
+ *
+ * See the implicit list's stalloc_t::stats(). The largest free block
+ * is read back from the free structure instead of the block list:
+ * the rightmost node of the treap, or the largest block of the
+ * highest non-empty size class. The single freelist (LIFO or address
+ * order without best fit) has no size order to read it from, so
+ * there it is only an upper bound once stale: the largest block
+ * created since it was last exact, lowered by failed searches (see
+ * find_fit()).
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+const stalloc_stats_t& stalloc_dyn_t<T, F, O, L, W, C, Narrow>::stats() {
+    /* No block list without a buffer (see BUF_SIZE) */
+    if (!m_size)
+        return m_stats;
+
+    if (m_stale) {
+        if constexpr (TREE) {
+            m_stats.largest = 0;
+            for (fl_t* flp = m_flists[0]; flp; flp = flp->next)
+                m_stats.largest = GET_SIZE(HDRP(flp));
+            m_stale = false;
+        } else if constexpr (SEG) {
+            m_stats.largest = 0;
+            if (m_flmap) {
+                for (fl_t* flp = m_flists[std::bit_width(m_flmap) - 1]; flp; flp = flp->next)
+                    m_stats.largest = (GET_SIZE(HDRP(flp)) > m_stats.largest) ? GET_SIZE(HDRP(flp)) : m_stats.largest;
+            }
+            m_stale = false;
+        } else {
+            m_stats.largest = (m_maxfree < m_stats.largest) ? m_maxfree : m_stats.largest;
+        }
+    }
+
+    m_stats.used = m_size - DSIZE - m_stats.free_bytes;
+    return m_stats;
+}
+#endif
+
+/**
+ * stalloc_dyn_t::can_alloc()
+ *
+ * See the implicit list's stalloc_t::can_alloc(). With
+ * stalloc_coa_t::lazy_coalesce, a non-empty quick list of the
+ * request's size is a fit as well.
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+bool stalloc_dyn_t<T, F, O, L, W, C, Narrow>::can_alloc(const size_t size) {
+    /* Ignore zero-sized and known-too-large requests */
+    if (!size || size > m_size - (2 * DSIZE))
+        return false;
+
+    drain();
+
+    const size_t asize = ALIGN_SIZE(size);
+
+    if constexpr (LAZY) {
+        if (asize < SEG_SMALL && m_qlists[QL_INDEX(asize)])
+            return true;
+    }
 
-    fl_insert(vbp);
-    coalesce(vbp);
+    return find_fit(asize) != nullptr;
 }
 
 /**
- * stalloc_t::coalesce()
+ * stalloc_dyn_t::usable_size()
+ *
+ * See the implicit list's stalloc_t::usable_size(). The block size
+ * less its header and footer, or its header alone with
+ * stalloc_ftr_t::elide_ftrs (compact words with compact tags).
+ */
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+size_t stalloc_dyn_t<T, F, O, L, W, C, Narrow>::usable_size(T* const bp) {
+    void* const vbp = static_cast<void*>(bp);
+
+    /* Ignore invalid requests */
+    if (!vbp || !GET_ALLOC(HDRP(vbp)))
+        return 0;
+
+    return GET_SIZE(HDRP(vbp)) - (ELIDE ? WSIZE : DSIZE);
+}
+
+/**
+ * stalloc_dyn_t::coalesce()
  *
  * Attempt to coalesce adjacent free blocks. In order to coalesce,
  * adjacent block must both exist (i.e. given block pointer is not
  * at a boundary) and have its alloc flag set to false.
+ *
+ * With stalloc_ord_t::seg_order (or the best fit treap) the merged
+ * block changes size class (key), so it is removed before and
+ * re-inserted after its tags are rewritten.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ord_t O>
-void stalloc_t<MaxSize, T, F, O>::coalesce(void* const bp) {
-    const bool prev = PREV_EXIST(bp) && !GET_ALLOC(HDRP(PREV_BLKP(bp)));
+template<typename T, stalloc_fit_t F, stalloc_ord_t O, stalloc_ftr_t L, stalloc_tag_t W, stalloc_coa_t C, bool Narrow>
+void stalloc_dyn_t<T, F, O, L, W, C, Narrow>::coalesce(void* const bp) {
+    const bool prev = PREV_FREE(bp);
     const bool next = NEXT_EXIST(bp) && !GET_ALLOC(HDRP(NEXT_BLKP(bp)));
 
     void* prev_hdrp = nullptr;
@@ -365,12 +1284,28 @@ void stalloc_t<MaxSize, T, F, O>::coalesce(void* const bp) {
         size += GET_SIZE(next_hdrp);
     }
 
+    /* Merged blocks are replaced by a single free block */
+    if (prev)
+        st_sub(GET_SIZE(prev_hdrp));
+    if (next)
+        st_sub(GET_SIZE(next_hdrp));
+    if (prev || next) {
+        st_sub(GET_SIZE(HDRP(bp)));
+        st_add(size);
+    }
+
+    void* const mbp = prev ? PREV_BLKP(bp) : bp;
+    if constexpr (SEG || TREE) {
+        if (prev || next)
+            fl_remove(mbp);
+    }
+
     if (prev && next) {
         fl_remove(NEXT_BLKP(bp));
         fl_remove(bp);
 
         PUT(prev_ftrp, 0);
-        PUT(prev_hdrp, PACK(size, false));
+        PUT(prev_hdrp, PACK(size, false, ELIDE));
 
         PUT(next_ftrp, PACK(size, false));
         PUT(next_hdrp, 0);
@@ -381,7 +1316,7 @@ void stalloc_t<MaxSize, T, F, O>::coalesce(void* const bp) {
         fl_remove(bp);
 
         PUT(prev_ftrp, 0);
-        PUT(prev_hdrp, PACK(size, false));
+        PUT(prev_hdrp, PACK(size, false, ELIDE));
 
         PUT(FTRP(bp), PACK(size, false));
         PUT(HDRP(bp), 0);
@@ -392,6 +1327,87 @@ void stalloc_t<MaxSize, T, F, O>::coalesce(void* const bp) {
         PUT(next_hdrp, 0);
 
         PUT(FTRP(bp), 0);
-        PUT(HDRP(bp), PACK(size, false));
+        PUT(HDRP(bp), PACK(size, false, ELIDE));
+    }
+
+    if constexpr (SEG || TREE) {
+        if (prev || next)
+            fl_insert(mbp);
     }
 }
+
+/**
+ * stalloc_store_t
+ *
+ * Buffer of a stalloc_t: embedded in the allocator (inline_mem),
+ * supplied by the caller (extern_mem), or an anonymous mapping owned
+ * by the allocator (mapped_mem, see stalloc_region_t). Held in a base
+ * class so that it exists before the engine that runs over it.
+ */
+template<size_t MaxSize, stalloc_mem_t M>
+struct stalloc_store_t {
+    alignas(2 * sizeof(void*)) unsigned char m_buf[MaxSize] = {0};
+
+    void* buf() { return m_buf; }
+};
+
+template<size_t MaxSize>
+struct stalloc_store_t<MaxSize, stalloc_mem_t::extern_mem> {
+    void* const m_buf;
+
+    explicit stalloc_store_t(void* const buf) : m_buf(buf) {}
+    void* buf() { return m_buf; }
+};
+
+template<size_t MaxSize>
+struct stalloc_store_t<MaxSize, stalloc_mem_t::mapped_mem> {
+    stalloc_region_t m_region;
+
+    explicit stalloc_store_t(const stalloc_map_opts_t& opts) : m_region(MaxSize, opts) {}
+    void* buf() { return m_region.data(); }
+};
+
+/**
+ * stalloc_t
+ *
+ * Explicit list allocator over a buffer of MaxSize bytes. Allocation
+ * is done by stalloc_dyn_t, shared by every MaxSize (compact tags
+ * only split buffers of up to 64 KiB, which get 16-bit tags, from
+ * larger ones).
+ */
+template<size_t MaxSize, typename T = void, stalloc_fit_t F = stalloc_fit_t::first_fit,
+                                            stalloc_ord_t O = stalloc_ord_t::lifo_order,
+                                            stalloc_ftr_t L = stalloc_ftr_t::keep_ftrs,
+                                            stalloc_tag_t W = stalloc_tag_t::wide_tags,
+                                            stalloc_coa_t C = stalloc_coa_t::eager_coalesce,
+                                            stalloc_mem_t M = stalloc_mem_t::inline_mem>
+class stalloc_t : private stalloc_store_t<MaxSize, M>,
+                  public stalloc_dyn_t<T, F, O, L, W, C, (W == stalloc_tag_t::compact_tags && MaxSize <= 65536)> {
+    using store_t = stalloc_store_t<MaxSize, M>;
+    using dyn_t = stalloc_dyn_t<T, F, O, L, W, C, (W == stalloc_tag_t::compact_tags && MaxSize <= 65536)>;
+
+    /* Ensure MaxSize is double-word aligned and can fit at least one block */
+    static_assert(((MaxSize & (dyn_t::ALIGNMENT - 1)) == 0) && (MaxSize >= 3 * dyn_t::ALIGNMENT));
+
+    /* Ensure sizes fit a tag */
+    static_assert(MaxSize <= dyn_t::MAX_SIZE);
+
+    public:
+        /* Buffer lies within the allocator object itself */
+        static constexpr bool INLINE_BUF = (M == stalloc_mem_t::inline_mem);
+
+        stalloc_t() requires (M == stalloc_mem_t::inline_mem) : dyn_t(store_t::buf(), MaxSize) {}
+
+        /* External buffer of (at least) MaxSize bytes, DSIZE aligned, which
+         * must outlive the allocator */
+        explicit stalloc_t(void* const buf) requires (M == stalloc_mem_t::extern_mem)
+            : store_t(buf), dyn_t(store_t::buf(), MaxSize) {}
+
+        /* Mapped buffer of MaxSize bytes, placed as given by opts. If the
+         * mapping fails every allocation fails */
+        explicit stalloc_t(const stalloc_map_opts_t& opts = {}) requires (M == stalloc_mem_t::mapped_mem)
+            : store_t(opts), dyn_t(store_t::buf(), MaxSize) {}
+
+        /* Mapping backing the buffer (e.g. to check huge() or bound()) */
+        const stalloc_region_t& region() const requires (M == stalloc_mem_t::mapped_mem) { return store_t::m_region; }
+};
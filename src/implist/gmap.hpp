@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STALLOC_GMAP_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * Granule map scans
+ *
+ * Find the first run of at least n set bits in a bitmap of `words`
+ * 64-bit words (a multiple of 4), returning the index of its first
+ * bit, or SIZE_MAX if there is none. Runs are tracked across words,
+ * and runs of up to 64 bits inside a word are found with a few
+ * shift-and steps instead of bit by bit.
+ *
+ * The vector versions test 2 (SSE2) or 4 (AVX2) words at once,
+ * skipping all-clear words (allocated space) and adding all-set
+ * words (free space) to the current run, and fall back to the word
+ * at a time scan for mixed words. stalloc_scan points at the best
+ * version supported by the CPU, chosen once at startup.
+ */
+using stalloc_scan_fn_t = size_t (*)(const uint64_t* const bits, const size_t words, const size_t n);
+
+/* Scan one word, given the length of the run of set bits ending just before it */
+inline bool stalloc_scan_word(const uint64_t x, const size_t w, size_t& run, const size_t n, size_t& g) {
+    /* Run continued from the previous words */
+    const size_t t = std::countr_one(x);
+    if (run + t >= n) {
+        g = w * 64 - run;
+        return true;
+    }
+
+    /* Runs starting and ending inside the word */
+    if (n <= 64) {
+        uint64_t m = x;
+        for (size_t s = 1; m && s < n;) {
+            const size_t k = std::min(s, n - s);
+            m &= m >> k;
+            s += k;
+        }
+        if (m) {
+            g = w * 64 + std::countr_zero(m);
+            return true;
+        }
+    }
+
+    run = (x == ~(uint64_t)0) ? run + 64 : std::countl_one(x);
+    return false;
+}
+
+inline size_t stalloc_scan_scalar(const uint64_t* const bits, const size_t words, const size_t n) {
+    size_t run = 0;
+    size_t g = SIZE_MAX;
+
+    for (size_t w = 0; w < words; w++) {
+        if (stalloc_scan_word(bits[w], w, run, n, g))
+            return g;
+    }
+    return SIZE_MAX;
+}
+
+#ifdef STALLOC_GMAP_X86
+[[gnu::target("sse2")]]
+inline size_t stalloc_scan_sse2(const uint64_t* const bits, const size_t words, const size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi32(-1);
+    size_t run = 0;
+    size_t g = SIZE_MAX;
+
+    for (size_t w = 0; w < words; w += 2) {
+        const __m128i v = _mm_load_si128((const __m128i*)(bits + w));
+
+        /* All allocated */
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) == 0xFFFF) {
+            run = 0;
+            continue;
+        }
+        /* All free */
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, ones)) == 0xFFFF) {
+            run += 128;
+            if (run >= n)
+                return (w + 2) * 64 - run;
+            continue;
+        }
+
+        if (stalloc_scan_word(bits[w], w, run, n, g) || stalloc_scan_word(bits[w + 1], w + 1, run, n, g))
+            return g;
+    }
+    return SIZE_MAX;
+}
+
+[[gnu::target("avx2")]]
+inline size_t stalloc_scan_avx2(const uint64_t* const bits, const size_t words, const size_t n) {
+    const __m256i ones = _mm256_set1_epi32(-1);
+    size_t run = 0;
+    size_t g = SIZE_MAX;
+
+    for (size_t w = 0; w < words; w += 4) {
+        const __m256i v = _mm256_load_si256((const __m256i*)(bits + w));
+
+        /* All allocated */
+        if (_mm256_testz_si256(v, v)) {
+            run = 0;
+            continue;
+        }
+        /* All free */
+        if (_mm256_testc_si256(v, ones)) {
+            run += 256;
+            if (run >= n)
+                return (w + 4) * 64 - run;
+            continue;
+        }
+
+        for (size_t i = w; i < w + 4; i++) {
+            if (stalloc_scan_word(bits[i], i, run, n, g))
+                return g;
+        }
+    }
+    return SIZE_MAX;
+}
+#endif
+
+inline const stalloc_scan_fn_t stalloc_scan = [] {
+#ifdef STALLOC_GMAP_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return &stalloc_scan_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return &stalloc_scan_sse2;
+#endif
+    return &stalloc_scan_scalar;
+}();
+
+/**
+ * stalloc_gmap_t
+ *
+ * Granule map of an implicit list: one bit per DSIZE granule of the
+ * block list, set while the granule belongs to a free block. Since
+ * free blocks are always coalesced, every maximal run of set bits is
+ * exactly one free block, so a free block of at least n granules is
+ * found by scanning the map for a run of n bits, rather than by
+ * walking the block list header by header.
+ *
+ * The map is padded with clear bits (at least one) to a multiple
+ * of 256 bits. Two summary bits per map word record whether it has
+ * any free granule, and whether all its granules are free, so that
+ * best fit, which visits every free run, skips allocated space and
+ * measures long free runs 4096 granules at a time.
+ */
+template<size_t Granules>
+class stalloc_gmap_t {
+    static constexpr size_t WORDS = (Granules + 256) / 256 * 4;
+    static constexpr size_t SWORDS = (WORDS + 63) / 64;
+
+    private:
+        alignas(32) uint64_t m_bits[WORDS] = {0};
+        uint64_t m_any[SWORDS] = {0};
+        uint64_t m_all[SWORDS] = {0};
+
+        /* Set or clear bit i of a bitmap */
+        static void put(uint64_t* const bits, const size_t i, const bool v) {
+            bits[i / 64] = v ? (bits[i / 64] | ((uint64_t)1 << (i % 64))) : (bits[i / 64] & ~((uint64_t)1 << (i % 64)));
+        }
+
+        /* Index of the first word at or after w whose summary bit is v, SWORDS * 64 if none */
+        static size_t skip(const uint64_t* const sum, const size_t w, const bool v) {
+            size_t s = w / 64;
+            if (s >= SWORDS)
+                return SWORDS * 64;
+            uint64_t y = (v ? sum[s] : ~sum[s]) & (~(uint64_t)0 << (w % 64));
+            while (!y) {
+                if (++s == SWORDS)
+                    return SWORDS * 64;
+                y = v ? sum[s] : ~sum[s];
+            }
+            return s * 64 + std::countr_zero(y);
+        }
+
+        void fill(size_t g, const size_t n, const bool free) {
+            const size_t end = g + n;
+            while (g < end) {
+                const size_t b = g % 64;
+                const size_t k = std::min(64 - b, end - g);
+                const uint64_t mask = ((k == 64) ? ~(uint64_t)0 : (((uint64_t)1 << k) - 1)) << b;
+                const size_t w = g / 64;
+                m_bits[w] = free ? (m_bits[w] | mask) : (m_bits[w] & ~mask);
+                put(m_any, w, m_bits[w]);
+                put(m_all, w, m_bits[w] == ~(uint64_t)0);
+                g += k;
+            }
+        }
+
+        /* Index of the first set bit at or after g, NONE if none */
+        size_t next_set(const size_t g) const {
+            size_t w = g / 64;
+            if (w >= WORDS)
+                return NONE;
+            const uint64_t x = m_bits[w] & (~(uint64_t)0 << (g % 64));
+            if (x)
+                return w * 64 + std::countr_zero(x);
+
+            /* Next word with a set bit */
+            w = skip(m_any, w + 1, true);
+            return (w < WORDS) ? w * 64 + std::countr_zero(m_bits[w]) : NONE;
+        }
+
+        /* Index of the first clear bit at or after g (the padding is clear) */
+        size_t next_clr(const size_t g) const {
+            size_t w = g / 64;
+            const uint64_t x = ~m_bits[w] & (~(uint64_t)0 << (g % 64));
+            if (x)
+                return w * 64 + std::countr_zero(x);
+
+            /* Next word with a clear bit */
+            w = skip(m_all, w + 1, false);
+            return w * 64 + std::countr_zero(~m_bits[w]);
+        }
+
+    public:
+        static constexpr size_t NONE = SIZE_MAX;
+
+        /* Mark n granules starting at g free (set) or allocated (clear) */
+        void set(const size_t g, const size_t n) { fill(g, n, true); }
+        void clr(const size_t g, const size_t n) { fill(g, n, false); }
+
+        /* First run of at least n free granules */
+        size_t first(const size_t n) const { return stalloc_scan(m_bits, WORDS, n); }
+
+        /* Smallest run of at least n free granules (the first, on ties) */
+        size_t best(const size_t n) const {
+            size_t bg = NONE;
+            size_t bg_size = NONE;
+
+            for (size_t g = next_set(0); g != NONE; ) {
+                const size_t e = next_clr(g);
+                if (e - g >= n && e - g < bg_size) {
+                    bg = g;
+                    bg_size = e - g;
+                    if (bg_size == n)
+                        break;
+                }
+                g = next_set(e);
+            }
+            return bg;
+        }
+
+        /* Length of the longest run of free granules */
+        size_t longest() const {
+            size_t n = 0;
+
+            for (size_t g = next_set(0); g != NONE; ) {
+                const size_t e = next_clr(g);
+                n = (e - g > n) ? e - g : n;
+                g = next_set(e);
+            }
+            return n;
+        }
+};
@@ -143,6 +143,133 @@ int main() {
     }
     st.printb();
 
+    /* Allocate 24B blocks with footer elision. Each block only needs a header, so
+     * it takes 32B instead of 48B: 4080B / 32B => 127 blocks (85 with footers) */
+    std::cout << std::endl << pr_inf << "allocating 24B blocks until full (footer elision)" << std::endl;
+    stalloc_t<4096, int, stalloc_fit_t::best_fit, stalloc_ftr_t::elide_ftrs> est;
+    int* dbuf[128] = {nullptr};
+    int dcnt = 0;
+    for (; dcnt < 128; dcnt++) {
+        if (!(dbuf[dcnt] = est.alloc(6 * sizeof(int))))
+            break;
+        for (int x = 0; x < 6; x++)
+            dbuf[dcnt][x] = dcnt;
+    }
+    std::cout << pr_inf << "allocated " << dcnt << " 24B blocks" << std::endl;
+    assert(dcnt == 127);
+
+    /* Free every second block, then the rest from last to first. Payloads must
+     * be intact since they now extend into where footers used to be */
+    std::cout << pr_inf << "freeing every second block, then the rest from last to first" << std::endl;
+    for (int idx = 1; idx < dcnt; idx += 2) {
+        assert(dbuf[idx][5] == idx);
+        est.free(dbuf[idx]);
+        dbuf[idx] = nullptr;
+    }
+    for (int idx = dcnt - 1; idx >= 0; idx -= 2) {
+        assert(dbuf[idx][5] == idx);
+        est.free(dbuf[idx]);
+        dbuf[idx] = nullptr;
+    }
+    est.printb();
+
+    i = est.alloc(1016 * sizeof(int));
+    assert(i);
+    est.free(i);
+    i = nullptr;
+
+    /* Allocate 48B blocks through handles around a pinned block, free every second
+     * one and compact in small steps. Moved blocks keep their contents, and the
+     * freed space merges into one block on each side of the pinned one */
+    std::cout << std::endl << pr_inf << "allocating 48 handle-owned 48B blocks around a pinned block" << std::endl;
+    stalloc_t<4096, int, stalloc_fit_t::first_fit, stalloc_ftr_t::keep_ftrs, 64> hst;
+    size_t hbuf[48] = {0};
+    for (int idx = 0; idx < 48; idx++) {
+        if (idx == 24) {
+            i = hst.alloc(4 * sizeof(int));
+            i[0] = -1;
+        }
+        hbuf[idx] = hst.halloc(12 * sizeof(int));
+        assert(hbuf[idx] != hst.NO_HANDLE);
+        hst.hptr(hbuf[idx])[11] = idx;
+    }
+    assert(hst.usable_size(hst.hptr(hbuf[0])) >= 12 * sizeof(int));
+
+    /* Handle-owned blocks cannot be freed by pointer */
+    hst.free(hst.hptr(hbuf[0]));
+    assert(hst.hptr(hbuf[0])[11] == 0);
+
+    std::cout << pr_inf << "freeing every second handle" << std::endl;
+    for (int idx = 0; idx < 48; idx += 2) {
+        hst.hfree(hbuf[idx]);
+        assert(!hst.hptr(hbuf[idx]));
+        hst.hfree(hbuf[idx]);
+    }
+    assert(!hst.can_alloc(900));
+
+    std::cout << pr_inf << "compacting (256B per step)" << std::endl;
+    int steps = 1;
+    while (!hst.compact(256))
+        steps++;
+    hst.printb();
+    std::cout << pr_inf << "compaction done in " << steps << " steps" << std::endl;
+    assert(steps > 1 && i[0] == -1);
+    for (int idx = 1; idx < 48; idx += 2)
+        assert(hst.hptr(hbuf[idx])[11] == idx);
+
+    j = hst.alloc(900);
+    assert(j);
+    hst.free(j);
+    hst.free(i);
+    for (int idx = 1; idx < 48; idx += 2)
+        hst.hfree(hbuf[idx]);
+    i = j = nullptr;
+    assert(hst.compact() && hst.can_alloc(4000));
+
+    /* Without the granule map, fits are found walking the block list, and the
+     * allocator (without handles) is its buffer and three words */
+    std::cout << std::endl << pr_inf << "allocating 16B blocks without the granule map" << std::endl;
+    stalloc_t<4096, int, stalloc_fit_t::first_fit, stalloc_ftr_t::keep_ftrs, 0, stalloc_map_t::no_map> nst;
+    struct flat_layout_t {
+        alignas(2 * sizeof(void*)) unsigned char data[4096];
+        void* listp;
+        void* rfreep;
+        size_t maxfree;
+    };
+    static_assert(sizeof(nst) == sizeof(flat_layout_t));
+    int* nbuf[8] = {nullptr};
+    for (int idx = 0; idx < 8; idx++) {
+        nbuf[idx] = nst.alloc(4 * sizeof(int));
+        assert(nbuf[idx]);
+    }
+    nst.free(nbuf[5]);
+    nst.free(nbuf[2]);
+    nst.printb();
+    assert(nst.alloc(4 * sizeof(int)) == nbuf[2] && nst.alloc(4 * sizeof(int)) == nbuf[5]);
+    for (int idx = 0; idx < 8; idx++)
+        nst.free(nbuf[idx]);
+    i = nst.alloc(1016 * sizeof(int));
+    assert(i);
+    nst.free(i);
+    i = nullptr;
+
+    /* The dispatched granule map scan must agree with the scalar one, for runs
+     * inside a word, across words, and across whole all-free vectors */
+    std::cout << std::endl << pr_inf << "checking granule map scans ("
+              << ((stalloc_scan == &stalloc_scan_scalar) ? "scalar" : "vector") << ")" << std::endl;
+    alignas(32) uint64_t gbuf[16] = {0};
+    gbuf[1] = 0x0000'0000'00FF'0000;
+    gbuf[2] = 0xFFFF'0000'0000'0000;
+    for (int idx = 3; idx < 8; idx++)
+        gbuf[idx] = ~(uint64_t)0;
+    gbuf[8] = 0x0000'0000'0000'00FF;
+    gbuf[9] = 0x0000'0000'FF00'FF00;
+    for (size_t n : {1, 8, 9, 16, 17, 200, 344, 345, 400}) {
+        const size_t g = stalloc_scan(gbuf, 16, n);
+        assert(g == stalloc_scan_scalar(gbuf, 16, n));
+        assert(g == ((n <= 8) ? 80 : (n <= 344) ? 176 : SIZE_MAX));
+    }
+
     /* Allocate and free entire buffer many times */
     std::cout << std::endl << pr_inf << "running performance test (65,536 loops)..." << std::endl;;
     auto start_time = std::chrono::high_resolution_clock::now();
@@ -1,22 +1,41 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <functional>
 #include <type_traits>
 
+#include "gmap.hpp"
+
+#ifdef STALLOC_TRACE
+#include "../trace/trace.hpp"
+#endif
+
+#ifdef STALLOC_STATS
+#include "../stats/stats.hpp"
+#endif
+
 enum stalloc_fit_t { first_fit, best_fit };
+enum stalloc_ftr_t { keep_ftrs, elide_ftrs };
+enum stalloc_map_t { no_map, granule_map };
 
-template<size_t MaxSize, typename T = void, stalloc_fit_t F = stalloc_fit_t::first_fit>
+template<size_t MaxSize, typename T = void, stalloc_fit_t F = stalloc_fit_t::first_fit,
+                                            stalloc_ftr_t L = stalloc_ftr_t::keep_ftrs,
+                                            size_t Handles = 0,
+                                            stalloc_map_t M = stalloc_map_t::granule_map>
 class stalloc_t {
     /* Word and double-word sizes, architecture dependant (bytes) */
     /* Note: On 64-bit architectures, alignment (DSIZE) is 16 bytes */
     static constexpr size_t WSIZE = sizeof(void*);
     static constexpr size_t DSIZE = 2 * WSIZE;
 
-    /* Pack size and alloc bit into a word for header/footer */
+    /* Pack size, alloc bit and previous block alloc bit into a word for header/footer */
     /* Note: size is assumed to be DSIZE aligned */
-    static constexpr uintptr_t PACK(size_t size, bool alloc) { return (size | alloc); }
+    static constexpr uintptr_t PACK(size_t size, bool alloc, bool palloc = false) { return (size | alloc | (palloc << 1)); }
 
     /* Read and write a word at address p */
     static constexpr uintptr_t GET(void* p) { return *(uintptr_t*)p; }
@@ -25,6 +44,7 @@ class stalloc_t {
     /* Read size and alloc fields from address p */
     static constexpr size_t GET_SIZE(void* p) { return GET(p) & ~(DSIZE - 1); }
     static constexpr size_t GET_ALLOC(void* p) { return GET(p) & 0x1; }
+    static constexpr bool GET_PALLOC(void* p) { return GET(p) & 0x2; }
 
     /* Get header/footer address from block pointer */
     static constexpr void* HDRP(void* bp) { return (void*)((size_t)bp - WSIZE); }
@@ -38,13 +58,38 @@ class stalloc_t {
     static constexpr bool PREV_EXIST(void* bp) { return GET((void*)((size_t)bp - DSIZE)); }
     static constexpr bool NEXT_EXIST(void* bp) { return GET((void*)((size_t)bp + GET_SIZE(HDRP(bp)) - WSIZE)); }
 
+    /* Footer elision: allocated blocks carry no footer, instead every header
+     * records whether the previous block is allocated (see GET_PALLOC) */
+    static constexpr bool ELIDE = (L == stalloc_ftr_t::elide_ftrs);
+
+    /* Set previous block alloc bit in the header of block bp */
+    static constexpr void SET_PALLOC(void* bp, bool palloc) { PUT(HDRP(bp), (GET(HDRP(bp)) & ~(uintptr_t)0x2) | (palloc << 1)); }
+
+    /* Check if previous block exists and is free */
+    static constexpr bool PREV_FREE(void* bp) { return ELIDE ? !GET_PALLOC(HDRP(bp)) : PREV_EXIST(bp) && !GET_ALLOC(HDRP(PREV_BLKP(bp))); }
+
+    /* Handle-owned (movable) blocks: header bit 0x4 is set, and the last
+     * word of the payload holds the index of the owning handle */
+    static constexpr bool GET_MOVABLE(void* p) { return GET(p) & 0x4; }
+    static constexpr void SET_MOVABLE(void* bp) { PUT(HDRP(bp), GET(HDRP(bp)) | 0x4); }
+    static constexpr void* HIDXP(void* bp) { return (void*)((size_t)bp + GET_SIZE(HDRP(bp)) - (ELIDE ? DSIZE : DSIZE + WSIZE)); }
+
+    /* Granule map: granule index of a block, and block at a granule index.
+     * Without it (stalloc_map_t::no_map) free blocks are found by walking
+     * the block list, and the allocator keeps its plain buffer footprint */
+    static constexpr bool MAP = (M == stalloc_map_t::granule_map);
+    static constexpr size_t GRANULES = (MaxSize - DSIZE) / DSIZE;
+    constexpr size_t GRAN(void* bp) const { return ((size_t)bp - (size_t)m_listp) / DSIZE; }
+    constexpr void* GRANP(size_t g) const { return (void*)((size_t)m_listp + g * DSIZE); }
+
     /* Calculate offset between two pointers */
     static constexpr size_t OFFSET(void* p, void* b) { return (size_t)p - (size_t)b; }
 
     /* Alignment helpers */
     static constexpr size_t ALIGN_MASK(size_t x, size_t m) { return (x + m) & (~m); }
     static constexpr size_t ALIGN_UP(size_t x) { return ALIGN_MASK(x, DSIZE-1); }
-    static constexpr size_t ALIGN_SIZE(size_t x) { return (x > DSIZE) ? ALIGN_UP(x) + DSIZE : 2 * DSIZE; }
+    static constexpr size_t ALIGN_SIZE(size_t x) { return ELIDE ? ((x > DSIZE + WSIZE) ? ALIGN_UP(x + WSIZE) : 2 * DSIZE)
+                                                               : ((x > DSIZE) ? ALIGN_UP(x) + DSIZE : 2 * DSIZE); }
 
     /* Ensure T is a trivially copyable type (or void) */
     static_assert(std::is_trivially_copyable_v<T> || std::is_void_v<T>);
@@ -53,22 +98,169 @@ class stalloc_t {
     static_assert(((MaxSize & (DSIZE-1)) == 0) && (MaxSize >= 3 * DSIZE));
 
     private:
-        unsigned char m_data[MaxSize] = {0};
+        alignas(DSIZE) unsigned char m_data[MaxSize] = {0};
         void* const m_listp = m_data + DSIZE;
+        std::atomic<void*> m_rfreep = nullptr;
+
+        /* Free granules, searched by find_fit() (see stalloc_gmap_t) */
+        struct gm_none_t {};
+        [[no_unique_address]] std::conditional_t<MAP, stalloc_gmap_t<GRANULES>, gm_none_t> m_map;
+
+        /* Mark size bytes of granules from block bp free (gm_set) or allocated (gm_clr) */
+        void gm_set([[maybe_unused]] void* const bp, [[maybe_unused]] const size_t size) {
+            if constexpr (MAP)
+                m_map.set(GRAN(bp), size / DSIZE);
+        }
+        void gm_clr([[maybe_unused]] void* const bp, [[maybe_unused]] const size_t size) {
+            if constexpr (MAP)
+                m_map.clr(GRAN(bp), size / DSIZE);
+        }
+
+        /* Handle table. Live entries point at their block, free entries at
+         * the next free entry (or nullptr). Takes no space without handles */
+        struct hd_t {
+            void* handles[Handles] = {nullptr};
+            void* freep = nullptr;
+
+            /* Block at which compact() resumes */
+            void* cpos = nullptr;
+        };
+        struct hd_none_t {};
+        [[no_unique_address]] std::conditional_t<(Handles > 0), hd_t, hd_none_t> m_hd;
+
+        /* Keep m_hd.cpos at a block boundary when blocks are merged into bp */
+        void cp_fix(void* const bp) {
+            if constexpr (Handles > 0) {
+                if ((size_t)m_hd.cpos > (size_t)bp && (size_t)m_hd.cpos < (size_t)NEXT_BLKP(bp))
+                    m_hd.cpos = bp;
+            }
+        }
+
+#ifdef STALLOC_TRACE
+        stalloc_trace_t* m_trace = nullptr;
+
+        void trace_rec(const stalloc_op_t op, void* const bp, const size_t size) {
+            if (m_trace)
+                m_trace->record(op, bp ? (uint32_t)((size_t)bp - (size_t)m_data) : stalloc_trace_t::NO_HANDLE,
+                                (uint32_t)size);
+        }
+#endif
+
+#ifdef STALLOC_STATS
+        stalloc_stats_t m_stats;
+        bool m_stale = false;
+#endif
+
+        /* Upper bound on the largest free block (see find_fit()) */
+        size_t m_maxfree = 0;
+
+        /* Free block bookkeeping, called as free blocks are created (st_add)
+         * and destroyed (st_sub). Only m_maxfree is kept unless STALLOC_STATS
+         * is defined. The largest free block in statistics is only an upper
+         * bound (stale) once a block of its size has been destroyed, until
+         * stats() reads it back */
+        void st_add(const size_t size) {
+            m_maxfree = (size > m_maxfree) ? size : m_maxfree;
+#ifdef STALLOC_STATS
+            m_stats.free_bytes += size;
+            m_stats.free_blocks++;
+            m_stats.classes[stalloc_stats_t::CLASS(size)]++;
+            m_stats.largest = (size > m_stats.largest) ? size : m_stats.largest;
+#endif
+        }
+        void st_sub([[maybe_unused]] const size_t size) {
+#ifdef STALLOC_STATS
+            m_stats.free_bytes -= size;
+            m_stats.free_blocks--;
+            m_stats.classes[stalloc_stats_t::CLASS(size)]--;
+            m_stale |= (size == m_stats.largest);
+#endif
+        }
+        void st_peak() {
+#ifdef STALLOC_STATS
+            m_stats.used = MaxSize - DSIZE - m_stats.free_bytes;
+            m_stats.peak = (m_stats.used > m_stats.peak) ? m_stats.used : m_stats.peak;
+#endif
+        }
+        void st_alloc([[maybe_unused]] const void* const bp, [[maybe_unused]] const size_t n = 1) {
+#ifdef STALLOC_STATS
+            if (bp) {
+                m_stats.allocs += n;
+                st_peak();
+            } else {
+                m_stats.fails++;
+            }
+#endif
+        }
+        void st_free() {
+#ifdef STALLOC_STATS
+            m_stats.frees++;
+#endif
+        }
 
         void* find_fit(const size_t asize);
         void place(void* const bp, size_t asize);
         void coalesce(void* const bp);
+        void split(void* const bp, const size_t asize);
+        void release(void* const bp);
 
     public:
         stalloc_t() {
             /* First and last words are reserved */
-            PUT(m_data + WSIZE, PACK(MaxSize - DSIZE, false));
+            PUT(m_data + WSIZE, PACK(MaxSize - DSIZE, false, ELIDE));
             PUT(FTRP(m_data + DSIZE), PACK(MaxSize - DSIZE, false));
+
+            st_add(MaxSize - DSIZE);
+            gm_set(m_listp, MaxSize - DSIZE);
+
+            if constexpr (Handles > 0) {
+                for (size_t h = 0; h + 1 < Handles; h++)
+                    m_hd.handles[h] = &m_hd.handles[h + 1];
+                m_hd.freep = &m_hd.handles[0];
+                m_hd.cpos = m_listp;
+            }
         };
 
+        /* Headers of allocated blocks are rewritten as their neighbours change */
+        static constexpr bool ELIDE_FTRS = ELIDE;
+
+        /* Invalid handle, returned by halloc() on failure */
+        static constexpr size_t NO_HANDLE = Handles;
+
         [[nodiscard]] T* alloc(const size_t size);
+        [[nodiscard]] T* alloc_aligned(const size_t size, const size_t align);
         void free(T* const bp);
+        [[nodiscard]] T* realloc(T* const bp, const size_t size);
+        [[nodiscard]] size_t usable_size(T* const bp);
+        [[nodiscard]] bool can_alloc(const size_t size);
+
+        /* Batched allocation/de-allocation of many blocks at once */
+        [[nodiscard]] size_t alloc_batch(const size_t size, const size_t n, T** const out);
+        void free_batch(T** const ptrs, const size_t n);
+
+        /* Cross-thread de-allocation */
+        void free_remote(T* const bp);
+        void drain();
+
+        /* Relocatable allocation through handles, and incremental compaction */
+        [[nodiscard]] size_t halloc(const size_t size) requires (Handles > 0);
+        void hfree(const size_t h) requires (Handles > 0);
+        [[nodiscard]] T* hptr(const size_t h) const requires (Handles > 0);
+        bool compact(const size_t budget = SIZE_MAX) requires (Handles > 0);
+
+#ifdef STALLOC_STATS
+        /* Allocator statistics (see stalloc_stats_t) */
+        const stalloc_stats_t& stats();
+#endif
+
+#ifdef STALLOC_TRACE
+        /* Attach (or detach, given nullptr) an allocation trace recorder */
+        void trace(stalloc_trace_t* const tr) {
+            m_trace = tr;
+            if (tr)
+                tr->attach(MaxSize);
+        }
+#endif
 
         /* Debug */
         void printb();
@@ -80,8 +272,8 @@ class stalloc_t {
  * Print a formatted representation of the instantiated stack
  * allocator's block list.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F>
-void stalloc_t<MaxSize, T, F>::printb() {
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+void stalloc_t<MaxSize, T, F, L, Handles, M>::printb() {
     printf("+------------------------------------------------+\n"
            "|                      Stack                     |\n"
            "+-------+----------------+--------------+--------+\n"
@@ -105,29 +297,66 @@ void stalloc_t<MaxSize, T, F>::printb() {
  * Fit algorithm may be chosen at compile time/instantiation
  * via the stalloc_fit_t type template parameter. Defaults to
  * stalloc_type_t::first_fit.
+ *
+ * With stalloc_map_t::granule_map (the default), free blocks are
+ * found in the granule map (see stalloc_gmap_t) rather than by
+ * walking the block list: first fit scans it for a run of
+ * asize / DSIZE free granules with the widest vector unit
+ * available, best fit jumps from one run of free granules to the
+ * next a word at a time.
+ *
+ * Requests larger than m_maxfree, an upper bound on the largest
+ * free block, fail without searching. The bound is raised as free
+ * blocks are created, and lowered to just below asize whenever a
+ * search fails, so repeated oversized requests fail in constant
+ * time even when the free space is fragmented.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F>
-void* stalloc_t<MaxSize, T, F>::find_fit(const size_t asize) {
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+void* stalloc_t<MaxSize, T, F, L, Handles, M>::find_fit(const size_t asize) {
+    /* Known-too-large request */
+    if (asize > m_maxfree)
+        return nullptr;
+
     /* First Fit */
     if constexpr (F == stalloc_fit_t::first_fit) {
-        for (void* lp = m_listp; GET_SIZE(HDRP(lp)) > 0; lp = NEXT_BLKP(lp))
-            if (!GET_ALLOC(HDRP(lp)) && asize <= GET_SIZE(HDRP(lp)))
-                return lp;
+        if constexpr (MAP) {
+            const size_t g = m_map.first(asize / DSIZE);
+            if (g != m_map.NONE)
+                return GRANP(g);
+        } else {
+            for (void* lp = m_listp; GET_SIZE(HDRP(lp)) > 0; lp = NEXT_BLKP(lp))
+                if (!GET_ALLOC(HDRP(lp)) && asize <= GET_SIZE(HDRP(lp)))
+                    return lp;
+        }
+
+        m_maxfree = asize - DSIZE;
         return nullptr;
     }
+
     /* Best Fit */
     if constexpr (F == stalloc_fit_t::best_fit) {
-        void* bp = nullptr;
-        size_t bp_size = ~((size_t)0);
-
-        for (void* lp = m_listp; GET_SIZE(HDRP(lp)) > 0; lp = NEXT_BLKP(lp)) {
-            const size_t lp_size = GET_SIZE(HDRP(lp));
-            if (!GET_ALLOC(HDRP(lp)) && asize <= lp_size && lp_size < bp_size) {
-                bp = lp;
-                bp_size = lp_size;
+        if constexpr (MAP) {
+            const size_t g = m_map.best(asize / DSIZE);
+            if (g != m_map.NONE)
+                return GRANP(g);
+        } else {
+            void* bp = nullptr;
+            size_t bp_size = ~((size_t)0);
+
+            for (void* lp = m_listp; GET_SIZE(HDRP(lp)) > 0; lp = NEXT_BLKP(lp)) {
+                const size_t lp_size = GET_SIZE(HDRP(lp));
+                if (!GET_ALLOC(HDRP(lp)) && asize <= lp_size && lp_size < bp_size) {
+                    bp = lp;
+                    bp_size = lp_size;
+                }
             }
+
+            if (bp)
+                return bp;
         }
-        return bp;
+
+        m_maxfree = asize - DSIZE;
+        return nullptr;
     }
 }
 
@@ -139,24 +368,33 @@ void* stalloc_t<MaxSize, T, F>::find_fit(const size_t asize) {
  * The size placed in the header/footer includes that of the header and
  * footer themselves.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F>
-void stalloc_t<MaxSize, T, F>::place(void* const bp, size_t asize) {
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+void stalloc_t<MaxSize, T, F, L, Handles, M>::place(void* const bp, size_t asize) {
     /* Get current (free) block size and leftover block size */
     const size_t fsize = GET_SIZE(HDRP(bp));
     const size_t lsize = fsize - asize;
+    const bool palloc = GET_PALLOC(HDRP(bp));
+
+    st_sub(fsize);
 
     /* If leftover size is too small for another block, use all of free
      * block size. Otherwise set leftover block size accordingly */
     if (lsize < 2 * DSIZE) {
         asize = fsize;
     } else {
-        PUT(HDRP((void*)((size_t)bp + asize)), PACK(lsize, false));
+        PUT(HDRP((void*)((size_t)bp + asize)), PACK(lsize, false, ELIDE));
         PUT(FTRP((void*)((size_t)bp + asize)), PACK(lsize, false));
+        st_add(lsize);
     }
 
-    /* Write header and footer for newly allocated block */
-    PUT(HDRP(bp), PACK(asize, true));
-    PUT(FTRP(bp), PACK(asize, true));
+    /* Write header and footer for newly allocated block. With footer
+     * elision the next block records the allocation instead */
+    PUT(HDRP(bp), PACK(asize, true, palloc));
+    gm_clr(bp, asize);
+    if constexpr (!ELIDE)
+        PUT(FTRP(bp), PACK(asize, true));
+    else if (NEXT_EXIST(bp))
+        SET_PALLOC(NEXT_BLKP(bp), true);
 }
 
 /**
@@ -175,18 +413,88 @@ void stalloc_t<MaxSize, T, F>::place(void* const bp, size_t asize) {
  * The start address of the newly allotted block is always double-
  * word aligned, as is the size of the block.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F>
-T* stalloc_t<MaxSize, T, F>::alloc(const size_t size) {
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+T* stalloc_t<MaxSize, T, F, L, Handles, M>::alloc(const size_t size) {
     /* Ignore zero-sized and known-too-large requests */
     if (!size || size > MaxSize - (2 * DSIZE))
         return nullptr;
 
+    /* Reclaim blocks freed by other threads */
+    drain();
+
     void* bp = nullptr;
     const size_t asize = ALIGN_SIZE(size);
 
     if ((bp = find_fit(asize)))
         place(bp, asize);
 
+    st_alloc(bp);
+
+#ifdef STALLOC_TRACE
+    trace_rec(alloc_op, bp, size);
+#endif
+
+    return static_cast<T*>(bp);
+}
+
+/**
+ * stalloc_t::alloc_aligned()
+ *
+ * Aligned allocation subroutine. Same as alloc(), except that the
+ * start address of the allotted block is a multiple of align, which
+ * must be a power of two. Returns nullptr on failure.
+ *
+ * A fit is searched for with enough slack to reach the next aligned
+ * address. The free space before it is split off as a free block of
+ * its own; if that fragment would be too small for a block, the next
+ * aligned address is used instead. Aligned blocks are freed with
+ * free() as usual. realloc() only preserves DSIZE alignment.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+T* stalloc_t<MaxSize, T, F, L, Handles, M>::alloc_aligned(const size_t size, const size_t align) {
+    /* Ignore invalid alignments, zero-sized and known-too-large requests */
+    if (!align || (align & (align - 1)) || !size || size > MaxSize - (2 * DSIZE) || align > MaxSize)
+        return nullptr;
+
+    /* Every block is DSIZE aligned */
+    if (align <= DSIZE)
+        return alloc(size);
+
+    /* Reclaim blocks freed by other threads */
+    drain();
+
+    const size_t asize = ALIGN_SIZE(size);
+    void* bp = find_fit(asize + align + DSIZE);
+
+    /* Split off the free space before the aligned address */
+    size_t gap = bp ? (align - ((size_t)bp & (align - 1))) & (align - 1) : 0;
+    if (gap == DSIZE)
+        gap += align;
+    if (gap) {
+        const size_t fsize = GET_SIZE(HDRP(bp));
+        const bool palloc = GET_PALLOC(HDRP(bp));
+        void* const abp = (void*)((size_t)bp + gap);
+
+        st_sub(fsize);
+        PUT(HDRP(bp), PACK(gap, false, palloc));
+        PUT(FTRP(bp), PACK(gap, false));
+        PUT(HDRP(abp), PACK(fsize - gap, false));
+        PUT(FTRP(abp), PACK(fsize - gap, false));
+        st_add(gap);
+        st_add(fsize - gap);
+
+        bp = abp;
+    }
+
+    if (bp)
+        place(bp, asize);
+
+    st_alloc(bp);
+
+#ifdef STALLOC_TRACE
+    trace_rec(alloc_op, bp, size);
+#endif
+
     return static_cast<T*>(bp);
 }
 
@@ -199,19 +507,553 @@ T* stalloc_t<MaxSize, T, F>::alloc(const size_t size) {
  *
  * On success attempts to coalesce adjacent free blocks.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F>
-void stalloc_t<MaxSize, T, F>::free(T* const bp) {
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+void stalloc_t<MaxSize, T, F, L, Handles, M>::free(T* const bp) {
+    void* const vbp = static_cast<void*>(bp);
+
+    /* Ignore invalid requests (and blocks owned by a handle) */
+    if (!vbp || !GET_ALLOC(HDRP(vbp)) || GET_MOVABLE(HDRP(vbp)))
+        return;
+
+#ifdef STALLOC_TRACE
+    trace_rec(free_op, vbp, 0);
+#endif
+
+    st_free();
+    release(vbp);
+}
+
+/**
+ * stalloc_t::release()
+ *
+ * Free an allocated block and coalesce it with adjacent free
+ * blocks. Shared by free(), free_batch() and split(), which have
+ * already validated the block.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+void stalloc_t<MaxSize, T, F, L, Handles, M>::release(void* const bp) {
+    const size_t size = GET_SIZE(HDRP(bp));
+    PUT(HDRP(bp), PACK(size, false, GET_PALLOC(HDRP(bp))));
+    PUT(FTRP(bp), PACK(size, false));
+    st_add(size);
+    gm_set(bp, size);
+
+    if constexpr (ELIDE) {
+        if (NEXT_EXIST(bp))
+            SET_PALLOC(NEXT_BLKP(bp), false);
+    }
+
+    coalesce(bp);
+}
+
+/**
+ * stalloc_t::free_remote()
+ *
+ * De-allocation subroutine for threads other than the one owning
+ * the allocator. The block is pushed onto a lock-free queue of
+ * remotely freed blocks, linked through the first word of each
+ * block's payload. The owning thread frees queued blocks in
+ * drain(), which alloc() also calls on entry.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+void stalloc_t<MaxSize, T, F, L, Handles, M>::free_remote(T* const bp) {
     void* const vbp = static_cast<void*>(bp);
 
     /* Ignore invalid requests */
-    if (!vbp || !GET_ALLOC(HDRP(vbp)))
+    if (!vbp)
+        return;
+
+    void* head = m_rfreep.load(std::memory_order_relaxed);
+    do {
+        *(void**)vbp = head;
+    } while (!m_rfreep.compare_exchange_weak(head, vbp, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+}
+
+/**
+ * stalloc_t::drain()
+ *
+ * Free all blocks queued by free_remote(). Must only be called by
+ * the thread owning the allocator. The whole queue is detached
+ * in one exchange, so this costs a single plain load when the
+ * queue is empty.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+void stalloc_t<MaxSize, T, F, L, Handles, M>::drain() {
+    if (!m_rfreep.load(std::memory_order_relaxed))
+        return;
+
+    void* bp = m_rfreep.exchange(nullptr, std::memory_order_acquire);
+    while (bp) {
+        void* const next = *(void**)bp;
+        free(static_cast<T*>(bp));
+        bp = next;
+    }
+}
+
+/**
+ * stalloc_t::halloc()
+ *
+ * Relocatable allocation subroutine. Allocates a block of at least
+ * size bytes owned by a handle, which is returned. Returns NO_HANDLE
+ * on failure, or when all Handles handles are in use.
+ *
+ * The block may be moved by compact(), so it must be looked up with
+ * hptr() after every compaction, and freed with hfree() (free() and
+ * realloc() ignore it). It costs one word more than alloc(size),
+ * holding the index of its handle.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+size_t stalloc_t<MaxSize, T, F, L, Handles, M>::halloc(const size_t size) requires (Handles > 0) {
+    /* Ignore zero-sized requests, and requests with no free handle */
+    if (!size || size > MaxSize || !m_hd.freep)
+        return NO_HANDLE;
+
+    void* const bp = static_cast<void*>(alloc(size + WSIZE));
+    if (!bp)
+        return NO_HANDLE;
+
+    void** const hp = static_cast<void**>(m_hd.freep);
+    m_hd.freep = *hp;
+    *hp = bp;
+
+    const size_t h = hp - m_hd.handles;
+    SET_MOVABLE(bp);
+    PUT(HIDXP(bp), h);
+    return h;
+}
+
+/**
+ * stalloc_t::hfree()
+ *
+ * Free the block owned by the given handle, and the handle itself.
+ * Silently fails if given an invalid handle.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+void stalloc_t<MaxSize, T, F, L, Handles, M>::hfree(const size_t h) requires (Handles > 0) {
+    void* const bp = static_cast<void*>(hptr(h));
+
+    /* Ignore invalid requests */
+    if (!bp)
+        return;
+
+#ifdef STALLOC_TRACE
+    trace_rec(free_op, bp, 0);
+#endif
+
+    st_free();
+    release(bp);
+
+    m_hd.handles[h] = m_hd.freep;
+    m_hd.freep = &m_hd.handles[h];
+}
+
+/**
+ * stalloc_t::hptr()
+ *
+ * Returns the current address of the block owned by the given
+ * handle, valid until the next call to compact(). Returns nullptr
+ * for invalid handles.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+T* stalloc_t<MaxSize, T, F, L, Handles, M>::hptr(const size_t h) const requires (Handles > 0) {
+    if (h >= Handles)
+        return nullptr;
+
+    /* Free entries point into the table (or are nullptr) */
+    void* const bp = m_hd.handles[h];
+    if ((size_t)bp - (size_t)m_data >= MaxSize)
+        return nullptr;
+
+    return static_cast<T*>(bp);
+}
+
+/**
+ * stalloc_t::compact()
+ *
+ * Incremental compaction. Slides handle-owned blocks toward the
+ * start of the buffer, over the free block preceding them, which
+ * moves up past them and coalesces with whatever follows. Blocks
+ * allocated with alloc() are pinned: free space before them stays
+ * where it is. Handles of moved blocks are updated.
+ *
+ * Work is bounded by budget: each moved block counts its size in
+ * bytes, each block skipped DSIZE. A call that runs out of budget
+ * returns false, and the next call resumes where it stopped.
+ * Returns true once a pass reaches the end of the buffer, at which
+ * point free space not held back by pinned blocks is merged into
+ * a single block at the end.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+bool stalloc_t<MaxSize, T, F, L, Handles, M>::compact(const size_t budget) requires (Handles > 0) {
+    size_t work = 0;
+    void* bp = m_hd.cpos;
+
+    while (GET_SIZE(HDRP(bp)) > 0) {
+        if (work >= budget) {
+            m_hd.cpos = bp;
+            return false;
+        }
+
+        /* Allocated blocks stay in place */
+        if (GET_ALLOC(HDRP(bp))) {
+            bp = NEXT_BLKP(bp);
+            work += DSIZE;
+            continue;
+        }
+
+        /* Free block at the end of the buffer */
+        if (!NEXT_EXIST(bp))
+            break;
+
+        /* Free block before a pinned block, skip both */
+        void* const nbp = NEXT_BLKP(bp);
+        if (!GET_MOVABLE(HDRP(nbp))) {
+            bp = NEXT_BLKP(nbp);
+            work += DSIZE;
+            continue;
+        }
+
+        /* Swap the free block and the handle-owned block after it */
+        const size_t fsize = GET_SIZE(HDRP(bp));
+        const size_t nsize = GET_SIZE(HDRP(nbp));
+        const bool palloc = GET_PALLOC(HDRP(bp));
+
+        memmove(bp, nbp, nsize - (ELIDE ? WSIZE : DSIZE));
+        PUT(HDRP(bp), PACK(nsize, true, palloc));
+        if constexpr (!ELIDE)
+            PUT(FTRP(bp), PACK(nsize, true));
+        SET_MOVABLE(bp);
+        m_hd.handles[GET(HIDXP(bp))] = bp;
+        gm_clr(bp, nsize);
+
+        void* const fbp = NEXT_BLKP(bp);
+        PUT(HDRP(fbp), PACK(fsize, false, ELIDE));
+        PUT(FTRP(fbp), PACK(fsize, false));
+        gm_set(fbp, fsize);
+        if constexpr (ELIDE) {
+            if (NEXT_EXIST(fbp))
+                SET_PALLOC(NEXT_BLKP(fbp), false);
+        }
+        coalesce(fbp);
+
+#ifdef STALLOC_TRACE
+        trace_rec(free_op, nbp, 0);
+        trace_rec(alloc_op, bp, nsize - (ELIDE ? WSIZE : DSIZE) - WSIZE);
+#endif
+
+        bp = fbp;
+        work += nsize;
+    }
+
+    m_hd.cpos = m_listp;
+    return true;
+}
+
+/**
+ * stalloc_t::split()
+ *
+ * Shrink an allocated block to asize, freeing its tail (and
+ * coalescing it with the following block) when the tail is large
+ * enough to form another block.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+void stalloc_t<MaxSize, T, F, L, Handles, M>::split(void* const bp, const size_t asize) {
+    const size_t size = GET_SIZE(HDRP(bp));
+
+    if (size - asize < 2 * DSIZE)
+        return;
+
+    void* const tbp = (void*)((size_t)bp + asize);
+
+    PUT(HDRP(bp), PACK(asize, true, GET_PALLOC(HDRP(bp))));
+    if constexpr (!ELIDE)
+        PUT(FTRP(bp), PACK(asize, true));
+
+    PUT(HDRP(tbp), PACK(size - asize, true, ELIDE));
+    if constexpr (!ELIDE)
+        PUT(FTRP(tbp), PACK(size - asize, true));
+
+    release(tbp);
+}
+
+/**
+ * stalloc_t::realloc()
+ *
+ * Public facing re-allocation subroutine. Resizes the given block
+ * to at least size bytes, preserving its contents. Returns a pointer
+ * to the resized block on success. Returns nullptr on failure, in
+ * which case the given block is left untouched.
+ *
+ * A shrinking block splits off its tail in place. A growing block
+ * first absorbs the following free block, then the preceding free
+ * block (moving its contents down). Only if neither neighbour has
+ * room is a new block allocated and the contents copied.
+ *
+ * A nullptr block behaves as alloc(size). A zero size behaves as
+ * free(bp) and returns nullptr.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+T* stalloc_t<MaxSize, T, F, L, Handles, M>::realloc(T* const bp, const size_t size) {
+    void* const vbp = static_cast<void*>(bp);
+
+    if (!vbp)
+        return alloc(size);
+
+    if (!size) {
+        free(bp);
+        return nullptr;
+    }
+
+    /* Ignore invalid, handle-owned and known-too-large requests */
+    if (!GET_ALLOC(HDRP(vbp)) || GET_MOVABLE(HDRP(vbp)) || size > MaxSize - (2 * DSIZE))
+        return nullptr;
+
+    const size_t asize = ALIGN_SIZE(size);
+    const size_t csize = GET_SIZE(HDRP(vbp));
+
+    /* Shrink in place */
+    if (asize <= csize) {
+        split(vbp, asize);
+#ifdef STALLOC_TRACE
+        trace_rec(free_op, vbp, 0);
+        trace_rec(alloc_op, vbp, size);
+#endif
+        return bp;
+    }
+
+    void* const nbp = NEXT_BLKP(vbp);
+    const size_t nsize = (NEXT_EXIST(vbp) && !GET_ALLOC(HDRP(nbp))) ? GET_SIZE(HDRP(nbp)) : 0;
+    const bool palloc = GET_PALLOC(HDRP(vbp));
+
+    /* Grow in place into the following free block */
+    if (csize + nsize >= asize) {
+        st_sub(nsize);
+        gm_clr(nbp, nsize);
+        PUT(HDRP(vbp), PACK(csize + nsize, true, palloc));
+        if constexpr (!ELIDE)
+            PUT(FTRP(vbp), PACK(csize + nsize, true));
+        else if (NEXT_EXIST(vbp))
+            SET_PALLOC(NEXT_BLKP(vbp), true);
+        cp_fix(vbp);
+
+        split(vbp, asize);
+        st_peak();
+#ifdef STALLOC_TRACE
+        trace_rec(free_op, vbp, 0);
+        trace_rec(alloc_op, vbp, size);
+#endif
+        return bp;
+    }
+
+    /* Grow into the preceding (and following) free block, moving contents down */
+    if (PREV_FREE(vbp)) {
+        void* const pbp = PREV_BLKP(vbp);
+        const size_t tsize = GET_SIZE(HDRP(pbp)) + csize + nsize;
+
+        if (tsize >= asize) {
+            st_sub(GET_SIZE(HDRP(pbp)));
+            if (nsize)
+                st_sub(nsize);
+            const bool ppalloc = GET_PALLOC(HDRP(pbp));
+            gm_clr(pbp, tsize);
+
+            memmove(pbp, vbp, csize - (ELIDE ? WSIZE : DSIZE));
+            PUT(HDRP(pbp), PACK(tsize, true, ppalloc));
+            if constexpr (!ELIDE)
+                PUT(FTRP(pbp), PACK(tsize, true));
+            else if (NEXT_EXIST(pbp))
+                SET_PALLOC(NEXT_BLKP(pbp), true);
+            cp_fix(pbp);
+
+            split(pbp, asize);
+            st_peak();
+#ifdef STALLOC_TRACE
+            trace_rec(free_op, vbp, 0);
+            trace_rec(alloc_op, pbp, size);
+#endif
+            return static_cast<T*>(pbp);
+        }
+    }
+
+    /* Fall back to allocate, copy and free */
+    T* const rbp = alloc(size);
+    if (rbp) {
+        memcpy(static_cast<void*>(rbp), vbp, csize - (ELIDE ? WSIZE : DSIZE));
+        free(bp);
+    }
+    return rbp;
+}
+
+/**
+ * stalloc_t::alloc_batch()
+ *
+ * Public facing batch allocation subroutine. Allocates n blocks of
+ * size bytes each, writing their pointers to out. Returns the number
+ * of blocks allocated.
+ *
+ * The blocks are carved out of one contiguous free region found
+ * with a single search, so they are adjacent in address order. If
+ * no such region exists, blocks are allocated one at a time until
+ * the allocator runs out of space.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+size_t stalloc_t<MaxSize, T, F, L, Handles, M>::alloc_batch(const size_t size, const size_t n, T** const out) {
+    /* Ignore zero-sized and known-too-large requests */
+    if (!size || !n || !out || size > MaxSize - (2 * DSIZE))
+        return 0;
+
+    /* Reclaim blocks freed by other threads */
+    drain();
+
+    const size_t asize = ALIGN_SIZE(size);
+    void* bp = nullptr;
+
+    if (n <= MaxSize / asize && (bp = find_fit(n * asize))) {
+        place(bp, n * asize);
+
+        /* Split the placed region, the last block keeps any leftover */
+        const bool palloc = GET_PALLOC(HDRP(bp));
+        const size_t lsize = GET_SIZE(HDRP(bp)) - (n - 1) * asize;
+
+        for (size_t i = 0; i < n; i++) {
+            void* const cbp = (void*)((size_t)bp + i * asize);
+            const size_t csize = (i == n - 1) ? lsize : asize;
+
+            PUT(HDRP(cbp), PACK(csize, true, i ? ELIDE : palloc));
+            if constexpr (!ELIDE)
+                PUT(FTRP(cbp), PACK(csize, true));
+            out[i] = static_cast<T*>(cbp);
+
+#ifdef STALLOC_TRACE
+            trace_rec(alloc_op, cbp, size);
+#endif
+        }
+
+        st_alloc(bp, n);
+        return n;
+    }
+
+    size_t cnt = 0;
+    while (cnt < n && (out[cnt] = alloc(size)))
+        cnt++;
+    return cnt;
+}
+
+/**
+ * stalloc_t::free_batch()
+ *
+ * Public facing batch de-allocation subroutine. Frees the n blocks
+ * in ptrs, which is sorted by address in the process. Invalid and
+ * duplicate pointers are silently ignored.
+ *
+ * Each run of physically adjacent blocks is merged into a single
+ * block first, so it is freed and coalesced only once.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+void stalloc_t<MaxSize, T, F, L, Handles, M>::free_batch(T** const ptrs, const size_t n) {
+    if (!ptrs)
         return;
 
-    const size_t size = GET_SIZE(HDRP(vbp));
-    PUT(HDRP(vbp), PACK(size, false));
-    PUT(FTRP(vbp), PACK(size, false));
+    std::sort(ptrs, ptrs + n, std::less<T*>());
+
+    void* end = nullptr;
+    for (size_t i = 0; i < n; i++) {
+        void* const vbp = static_cast<void*>(ptrs[i]);
+
+        /* Ignore invalid requests, handle-owned blocks, and blocks already part of a run */
+        if (!vbp || (size_t)vbp < (size_t)end || !GET_ALLOC(HDRP(vbp)) || GET_MOVABLE(HDRP(vbp)))
+            continue;
+
+#ifdef STALLOC_TRACE
+        trace_rec(free_op, vbp, 0);
+#endif
+        st_free();
+
+        /* Extend the run while the next pointer is the next allocated block */
+        end = NEXT_BLKP(vbp);
+        for (; i + 1 < n && static_cast<void*>(ptrs[i + 1]) == end && GET_ALLOC(HDRP(end)) && !GET_MOVABLE(HDRP(end)); i++) {
+#ifdef STALLOC_TRACE
+            trace_rec(free_op, end, 0);
+#endif
+            st_free();
+            end = NEXT_BLKP(end);
+        }
+
+        const size_t size = (size_t)end - (size_t)vbp;
+        PUT(HDRP(vbp), PACK(size, true, GET_PALLOC(HDRP(vbp))));
+        if constexpr (!ELIDE)
+            PUT(FTRP(vbp), PACK(size, true));
 
-    coalesce(vbp);
+        cp_fix(vbp);
+        release(vbp);
+    }
+}
+
+#ifdef STALLOC_STATS
+/**
+ * stalloc_t::stats()
+ *
+ * Returns the allocator statistics. All counters are maintained
+ * incrementally, except that the largest free block is read back
+ * from the granule map, as its longest run of free granules (or
+ * rescanned walking the block list, with stalloc_map_t::no_map),
+ * after the previous largest free block was allocated or merged.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+const stalloc_stats_t& stalloc_t<MaxSize, T, F, L, Handles, M>::stats() {
+    if (m_stale) {
+        if constexpr (MAP) {
+            m_stats.largest = m_map.longest() * DSIZE;
+        } else {
+            m_stats.largest = 0;
+            for (void* bp = m_listp; GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp)) {
+                if (!GET_ALLOC(HDRP(bp)) && GET_SIZE(HDRP(bp)) > m_stats.largest)
+                    m_stats.largest = GET_SIZE(HDRP(bp));
+            }
+        }
+        m_stale = false;
+    }
+
+    m_stats.used = MaxSize - DSIZE - m_stats.free_bytes;
+    return m_stats;
+}
+#endif
+
+/**
+ * stalloc_t::can_alloc()
+ *
+ * Returns true if alloc(size) would currently succeed, without
+ * allocating. Blocks freed by other threads are reclaimed first.
+ * Requests larger than the tracked bound on the largest free block
+ * are rejected in constant time (see find_fit()).
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+bool stalloc_t<MaxSize, T, F, L, Handles, M>::can_alloc(const size_t size) {
+    /* Ignore zero-sized and known-too-large requests */
+    if (!size || size > MaxSize - (2 * DSIZE))
+        return false;
+
+    drain();
+    return find_fit(ALIGN_SIZE(size)) != nullptr;
+}
+
+/**
+ * stalloc_t::usable_size()
+ *
+ * Returns the number of bytes usable by the caller in the given
+ * allocated block, which is at least the size requested from
+ * alloc(). Returns 0 if given an invalid request.
+ */
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+size_t stalloc_t<MaxSize, T, F, L, Handles, M>::usable_size(T* const bp) {
+    void* const vbp = static_cast<void*>(bp);
+
+    /* Ignore invalid requests */
+    if (!vbp || !GET_ALLOC(HDRP(vbp)))
+        return 0;
+
+    return GET_SIZE(HDRP(vbp)) - (ELIDE ? WSIZE : DSIZE) - (GET_MOVABLE(HDRP(vbp)) ? WSIZE : 0);
 }
 
 /**
@@ -221,9 +1063,9 @@ void stalloc_t<MaxSize, T, F>::free(T* const bp) {
  * adjacent block must both exist (i.e. given block pointer is not
  * at a boundary) and have its alloc flag set to false.
  */
-template<size_t MaxSize, typename T, stalloc_fit_t F>
-void stalloc_t<MaxSize, T, F>::coalesce(void* const bp) {
-    const bool prev = PREV_EXIST(bp) && !GET_ALLOC(HDRP(PREV_BLKP(bp)));
+template<size_t MaxSize, typename T, stalloc_fit_t F, stalloc_ftr_t L, size_t Handles, stalloc_map_t M>
+void stalloc_t<MaxSize, T, F, L, Handles, M>::coalesce(void* const bp) {
+    const bool prev = PREV_FREE(bp);
     const bool next = NEXT_EXIST(bp) && !GET_ALLOC(HDRP(NEXT_BLKP(bp)));
 
     void* prev_hdrp = nullptr;
@@ -243,9 +1085,19 @@ void stalloc_t<MaxSize, T, F>::coalesce(void* const bp) {
         size += GET_SIZE(next_hdrp);
     }
 
+    /* Merged blocks are replaced by a single free block */
+    if (prev)
+        st_sub(GET_SIZE(prev_hdrp));
+    if (next)
+        st_sub(GET_SIZE(next_hdrp));
+    if (prev || next) {
+        st_sub(GET_SIZE(HDRP(bp)));
+        st_add(size);
+    }
+
     if (prev && next) {
         PUT(prev_ftrp, 0);
-        PUT(prev_hdrp, PACK(size, false));
+        PUT(prev_hdrp, PACK(size, false, ELIDE));
 
         PUT(next_ftrp, PACK(size, false));
         PUT(next_hdrp, 0);
@@ -254,7 +1106,7 @@ void stalloc_t<MaxSize, T, F>::coalesce(void* const bp) {
         PUT(HDRP(bp), 0);
     } else if (prev) {
         PUT(prev_ftrp, 0);
-        PUT(prev_hdrp, PACK(size, false));
+        PUT(prev_hdrp, PACK(size, false, ELIDE));
 
         PUT(FTRP(bp), PACK(size, false));
         PUT(HDRP(bp), 0);
@@ -263,6 +1115,8 @@ void stalloc_t<MaxSize, T, F>::coalesce(void* const bp) {
         PUT(next_hdrp, 0);
 
         PUT(FTRP(bp), 0);
-        PUT(HDRP(bp), PACK(size, false));
+        PUT(HDRP(bp), PACK(size, false, ELIDE));
     }
+
+    cp_fix(prev ? (void*)((size_t)prev_hdrp + WSIZE) : bp);
 }
@@ -0,0 +1,139 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <list>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+#include "../explist/stalloc.hpp"
+#include "pmr.hpp"
+
+#define pr_inf "inf[" << __func__ << "]: "
+#define pr_err "err[" << __func__ << "]: "
+
+/* Count global heap allocations to check containers on stalloc never touch the heap */
+static size_t heap_allocs = 0;
+
+void* operator new(size_t size) {
+    heap_allocs++;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+/* Over-aligned element type */
+struct alignas(64) line_t {
+    int v[16];
+};
+
+/* Build and tear down a vector, a hash map and a list on the given resource */
+int container_test(std::pmr::memory_resource* res) {
+    int sum = 0;
+
+    std::pmr::vector<int> v(res);
+    for (int n = 0; n < 1024; n++)
+        v.push_back(n);
+
+    std::pmr::unordered_map<int, int> m(res);
+    for (int n = 0; n < 512; n++)
+        m[n] = n;
+    for (int n = 0; n < 512; n += 2)
+        m.erase(n);
+
+    std::pmr::list<int> l(res);
+    for (int n = 0; n < 512; n++)
+        l.push_back(n);
+
+    for (int n : v)
+        sum += n;
+    for (auto& kv : m)
+        sum += kv.second;
+    for (int n : l)
+        sum += n;
+    return sum;
+}
+
+int main() {
+    using arena_t = stalloc_t<262144, void, stalloc_fit_t::first_fit, stalloc_ord_t::seg_order>;
+    stalloc_resource_t<arena_t> res;
+
+    /* Containers on the stack resource must not allocate from the heap */
+    std::cout << std::endl << pr_inf << "building pmr containers on stalloc_resource_t" << std::endl;
+    size_t heap_before = heap_allocs;
+    const int sum = container_test(&res);
+    assert(heap_allocs == heap_before);
+    const int heap_sum = container_test(std::pmr::new_delete_resource());
+    assert(sum == heap_sum);
+
+    /* Everything must have been returned */
+    std::cout << pr_inf << "allocating block of max size" << std::endl;
+    void* p = res.allocate(262144 - 32);
+    res.deallocate(p, 262144 - 32);
+
+    /* Over-aligned requests */
+    std::cout << pr_inf << "allocating 64B aligned blocks" << std::endl;
+    void* q[8];
+    for (int idx = 0; idx < 8; idx++) {
+        q[idx] = res.allocate(8 * idx + 1, 64);
+        assert(((size_t)q[idx] & 63) == 0);
+    }
+    for (int idx = 0; idx < 8; idx++)
+        res.deallocate(q[idx], 8 * idx + 1, 64);
+
+    /* Aligned blocks come from alloc_aligned(), so the arena coalesces back whole */
+    p = res.allocate(262144 - 32);
+    res.deallocate(p, 262144 - 32);
+
+    /* Standard Allocator wrapper, including rebinding (list nodes) and alignof(U) */
+    std::cout << pr_inf << "building containers with stalloc_allocator_t" << std::endl;
+    heap_before = heap_allocs;
+    {
+        stalloc_allocator_t<int, arena_t> a(res.arena());
+        std::vector<int, stalloc_allocator_t<int, arena_t>> v(a);
+        std::list<int, stalloc_allocator_t<int, arena_t>> l(a);
+        std::vector<line_t, stalloc_allocator_t<line_t, arena_t>> lv(a);
+        for (int n = 0; n < 256; n++) {
+            v.push_back(n);
+            l.push_back(n);
+            lv.push_back(line_t{{n}});
+            assert(((size_t)lv.data() & 63) == 0);
+        }
+        assert(v.get_allocator() == lv.get_allocator());
+    }
+    assert(heap_allocs == heap_before);
+
+    /* Exhaustion throws std::bad_alloc */
+    std::cout << pr_inf << "trying to allocate block greater than max size" << std::endl;
+    bool thrown = false;
+    try {
+        p = res.allocate(262144);
+    } catch (const std::bad_alloc&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    /* Build and tear down the containers many times on each resource */
+    std::cout << std::endl << pr_inf << "running performance test (4,096 loops)..." << std::endl;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int l = 0; l < 4096; l++) {
+        const int lsum = container_test(&res);
+        assert(lsum == sum);
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "stalloc_resource_t done [" << dur_time.count() / 1000. << "s]" << std::endl;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int l = 0; l < 4096; l++) {
+        const int lsum = container_test(std::pmr::new_delete_resource());
+        assert(lsum == sum);
+    }
+    end_time = std::chrono::high_resolution_clock::now();
+    dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "std::pmr::new_delete_resource() done [" << dur_time.count() / 1000. << "s]" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+/**
+ * stalloc_resource_t
+ *
+ * std::pmr::memory_resource over any stalloc_t (A, instantiated with
+ * T = void), so that std::pmr containers run entirely out of the stack
+ * buffer. Allocation failure throws std::bad_alloc as required by the
+ * memory_resource contract.
+ *
+ * All alignments are served by alloc_aligned() where A provides it,
+ * since A may align blocks to less than DSIZE (e.g. with compact
+ * tags). Otherwise alignments up to DSIZE are served directly, and
+ * larger ones by over-allocating and storing the block pointer in the
+ * word preceding the aligned pointer.
+ */
+template<typename A>
+class stalloc_resource_t : public std::pmr::memory_resource {
+    /* Word and double-word sizes, architecture dependant (bytes) */
+    static constexpr size_t WSIZE = sizeof(void*);
+    static constexpr size_t DSIZE = 2 * WSIZE;
+
+    /* Pointer type handed out by the wrapped allocator */
+    using AT = decltype(std::declval<A&>().alloc(0));
+
+    /* Check if the wrapped allocator supports aligned allocation */
+    static constexpr bool ALIGNED = requires(A& a) { a.alloc_aligned(0, 0); };
+
+    private:
+        A m_arena;
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    public:
+        /* Aligned allocation from a wrapped allocator. Returns nullptr on failure */
+        static void* alloc(A& arena, const size_t bytes, const size_t alignment);
+        static void free(A& arena, void* const p, const size_t alignment);
+
+        /* Wrapped allocator */
+        A& arena() { return m_arena; }
+};
+
+/**
+ * stalloc_resource_t::alloc()
+ *
+ * Allocate bytes from the given allocator at the given (power of
+ * two) alignment. Zero-sized requests get a minimum sized block.
+ * Returns nullptr on failure.
+ */
+template<typename A>
+void* stalloc_resource_t<A>::alloc(A& arena, const size_t bytes, const size_t alignment) {
+    const size_t size = bytes ? bytes : 1;
+
+    if constexpr (ALIGNED)
+        return static_cast<void*>(arena.alloc_aligned(size, alignment));
+
+    if (alignment <= DSIZE)
+        return static_cast<void*>(arena.alloc(size));
+
+    /* Block pointers are DSIZE aligned, so an aligned pointer at least one
+     * byte past it leaves room for the stashed block pointer */
+    void* const bp = static_cast<void*>(arena.alloc(size + alignment));
+    if (!bp)
+        return nullptr;
+
+    void** const p = (void**)(((size_t)bp + alignment) & ~(alignment - 1));
+    p[-1] = bp;
+    return static_cast<void*>(p);
+}
+
+/**
+ * stalloc_resource_t::free()
+ *
+ * Free memory returned by alloc() with the same alignment.
+ */
+template<typename A>
+void stalloc_resource_t<A>::free(A& arena, void* const p, const size_t alignment) {
+    /* Ignore invalid requests */
+    if (!p)
+        return;
+
+    arena.free(static_cast<AT>((ALIGNED || alignment <= DSIZE) ? p : ((void**)p)[-1]));
+}
+
+/**
+ * stalloc_resource_t::do_allocate()
+ *
+ * std::pmr::memory_resource allocation hook.
+ */
+template<typename A>
+void* stalloc_resource_t<A>::do_allocate(size_t bytes, size_t alignment) {
+    void* const p = alloc(m_arena, bytes, alignment);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+/**
+ * stalloc_resource_t::do_deallocate()
+ *
+ * std::pmr::memory_resource de-allocation hook.
+ */
+template<typename A>
+void stalloc_resource_t<A>::do_deallocate(void* p, size_t, size_t alignment) {
+    free(m_arena, p, alignment);
+}
+
+/**
+ * stalloc_allocator_t
+ *
+ * Standard Allocator over a (non-owned) stalloc_t (A, instantiated
+ * with T = void), honoring alignof(U). Allocators compare equal when
+ * they refer to the same allocator.
+ */
+template<typename U, typename A>
+class stalloc_allocator_t {
+    template<typename, typename> friend class stalloc_allocator_t;
+
+    private:
+        A* m_arena;
+
+    public:
+        using value_type = U;
+
+        template<typename V>
+        struct rebind {
+            using other = stalloc_allocator_t<V, A>;
+        };
+
+        explicit stalloc_allocator_t(A& arena) noexcept : m_arena(&arena) {}
+
+        template<typename V>
+        stalloc_allocator_t(const stalloc_allocator_t<V, A>& other) noexcept : m_arena(other.m_arena) {}
+
+        [[nodiscard]] U* allocate(const size_t n) {
+            if (n > SIZE_MAX / sizeof(U))
+                throw std::bad_array_new_length();
+
+            void* const p = stalloc_resource_t<A>::alloc(*m_arena, n * sizeof(U), alignof(U));
+            if (!p)
+                throw std::bad_alloc();
+            return static_cast<U*>(p);
+        }
+
+        void deallocate(U* const p, const size_t) noexcept {
+            stalloc_resource_t<A>::free(*m_arena, static_cast<void*>(p), alignof(U));
+        }
+
+        template<typename V>
+        bool operator==(const stalloc_allocator_t<V, A>& other) const noexcept { return m_arena == other.m_arena; }
+};
@@ -0,0 +1,136 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../explist/stalloc.hpp"
+#include "pool.hpp"
+
+#define pr_inf "inf[" << __func__ << "]: "
+#define pr_err "err[" << __func__ << "]: "
+
+/* Arena without owns() */
+struct plain_t {
+    stalloc_t<4096> st;
+
+    void* alloc(const size_t size) { return st.alloc(size); }
+    void free(void* const bp) { st.free(bp); }
+    size_t usable_size(void* const bp) { return st.usable_size(bp); }
+};
+
+/* Print the occupancy of every arena of a pool */
+template<typename P>
+void printo(const P& pool, const size_t arenas) {
+    for (size_t a = 0; a < arenas; a++) {
+        const stalloc_occ_t o = pool.occupancy(a);
+        std::cout << pr_inf << "arena " << a << ": " << o.used << "B of " << o.capacity << "B ("
+                  << o.ratio() * 100 << "%), " << o.steals << " steals" << (o.owned ? ", owned" : "") << std::endl;
+    }
+}
+
+int main() {
+    static stalloc_pool_t<stalloc_t<4096>, int, 4> st;
+
+    int* i = nullptr;
+    int* j = nullptr;
+
+    /* The first allocation claims an arena for this thread */
+    std::cout << std::endl << pr_inf << "allocating a 2KB block (local arena)" << std::endl;
+    i = st.alloc(512 * sizeof(int));
+    assert(i && st.owns(i) && st.arena(0).owns(i));
+    assert(st.occupancy(0).owned && !st.occupancy(1).owned);
+    assert(st.occupancy(0).used == 2048 && st.occupancy(0).capacity == 4096);
+
+    /* The local arena cannot fit another 2KB, so it is stolen from the least occupied sibling */
+    std::cout << pr_inf << "allocating a 2KB block (stolen)" << std::endl;
+    j = st.alloc(512 * sizeof(int));
+    assert(j && st.arena(1).owns(j));
+    assert(st.occupancy(1).used == 2048 && st.occupancy(1).steals == 1 && !st.occupancy(1).owned);
+    printo(st, 4);
+
+    /* Blocks are routed back by address */
+    std::cout << std::endl << pr_inf << "freeing both blocks" << std::endl;
+    int x = 0;
+    assert(!st.owns(&x));
+    st.free(&x);
+    st.free(j);
+    st.free(i);
+    i = j = nullptr;
+    assert(st.occupancy(0).used == 0 && st.occupancy(1).used == 0);
+
+    /* Requests no arena can serve fail */
+    assert(!st.alloc(8192) && !st.alloc(0));
+
+    /* Arenas without owns() are found by address within the pool */
+    static stalloc_pool_t<plain_t, int, 2> ast;
+    i = ast.alloc(4 * sizeof(int));
+    assert(i && ast.owns(i) && !ast.owns(&x));
+    ast.free(i);
+    i = nullptr;
+
+    /* Once detached, the arena is claimed again by the next thread */
+    std::cout << pr_inf << "detaching, then allocating from another thread" << std::endl;
+    st.detach();
+    assert(!st.occupancy(0).owned);
+    std::thread([] {
+        int* const p = st.alloc(4 * sizeof(int));
+        assert(p && st.arena(0).owns(p));
+        st.free(p);
+        st.detach();
+    }).join();
+
+    /* Skewed load: one thread holds 40 256B blocks, three others 4 each. The busy
+     * thread lives off its siblings' spare capacity, and all blocks are freed
+     * by a thread other than the one that allocated them */
+    std::cout << std::endl << pr_inf << "running skewed load test (4 threads, 65,536 rounds)..." << std::endl;
+    static stalloc_pool_t<stalloc_t<4096>, int, 4> pst;
+    std::vector<int*> handoff[4];
+    auto start_time = std::chrono::high_resolution_clock::now();
+    {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 4; t++) {
+            workers.emplace_back([t, &handoff] {
+                const int cnt = (t == 0) ? 40 : 4;
+                int* live[40] = {nullptr};
+                for (int r = 0; r < 65536; r++) {
+                    for (int b = 0; b < cnt; b++) {
+                        live[b] = pst.alloc(64 * sizeof(int));
+                        assert(live[b]);
+                        live[b][63] = t * 64 + b;
+                    }
+                    for (int b = 0; b < cnt; b++) {
+                        assert(live[b][63] == t * 64 + b);
+                        pst.free(live[b]);
+                    }
+                }
+                for (int b = 0; b < cnt; b++)
+                    handoff[t].push_back(pst.alloc(64 * sizeof(int)));
+                pst.detach();
+            });
+        }
+        for (std::thread& w : workers)
+            w.join();
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "skewed load test done [" << dur_time.count() / 1000. << "s]" << std::endl;
+    printo(pst, 4);
+
+    size_t steals = 0;
+    for (size_t a = 0; a < 4; a++)
+        steals += pst.occupancy(a).steals;
+    assert(steals > 0);
+
+    std::thread([&handoff] {
+        for (std::vector<int*>& h : handoff) {
+            for (int* p : h) {
+                assert(p);
+                pst.free(p);
+            }
+        }
+    }).join();
+    for (size_t a = 0; a < 4; a++)
+        assert(pst.occupancy(a).used == 0 && !pst.occupancy(a).owned);
+
+    return 0;
+}
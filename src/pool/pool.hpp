@@ -0,0 +1,302 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+/**
+ * stalloc_occ_t
+ *
+ * Occupancy of one arena of a stalloc_pool_t, read with occupancy().
+ * Arenas far above the pool's average are being drained by their
+ * thread; a high steal count means other threads are living off
+ * this arena's spare capacity.
+ */
+struct stalloc_occ_t {
+    size_t used = 0;                /* Usable bytes of live blocks */
+    size_t capacity = 0;            /* Buffer size (bytes) */
+    uint64_t steals = 0;            /* Allocations served for other threads */
+    bool owned = false;             /* Arena is some thread's local arena */
+
+    /* Share of the buffer held by live blocks */
+    double ratio() const { return capacity ? (double)used / (double)capacity : 0.; }
+};
+
+/**
+ * stalloc_pool_t
+ *
+ * Per-thread arena pool over Arenas instances of any stalloc_t (A,
+ * instantiated with T = void). Each thread claims an arena of its
+ * own on first use and allocates from it. When the local arena is
+ * exhausted (or all arenas are claimed), the request is stolen from
+ * the sibling with the fewest bytes in use, then from the others in
+ * turn. Returns nullptr only when no arena can serve the request.
+ *
+ * free() routes blocks by address back to the arena that owns them,
+ * so blocks may be freed by any thread. Every arena is guarded by a
+ * spinlock, uncontended unless a sibling is stealing from it or
+ * freeing into it.
+ */
+template<typename A, typename T = void, size_t Arenas = 4>
+class stalloc_pool_t {
+    /* Arena with its lock and occupancy, cache line aligned to avoid false sharing */
+    struct alignas(64) slot_t {
+        A arena;
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        std::atomic<std::thread::id> owner;
+        std::atomic<size_t> used = 0;
+        std::atomic<uint64_t> steals = 0;
+    };
+
+    /* Calling thread's last used arena */
+    struct slot_memo_t {
+        const void* pool;
+        slot_t* slot;
+    };
+
+    /* Pointer type handed out by the wrapped allocator */
+    using AT = decltype(std::declval<A&>().alloc(0));
+
+    /* Ensure T is a trivially copyable type (or void) */
+    static_assert(std::is_trivially_copyable_v<T> || std::is_void_v<T>);
+
+    static_assert(Arenas > 0);
+
+    private:
+        slot_t m_slots[Arenas];
+
+        static inline thread_local slot_memo_t t_memo = {nullptr, nullptr};
+
+        static void lock(slot_t& s);
+        static void unlock(slot_t& s) { s.lock.clear(std::memory_order_release); }
+
+        slot_t* local();
+        slot_t* find(const void* const p);
+        void* try_alloc(slot_t& s, const size_t size);
+        T* steal(slot_t* const self, const size_t size);
+
+    public:
+        [[nodiscard]] T* alloc(const size_t size);
+        void free(T* const bp);
+
+        /* Give up the calling thread's arena (its live blocks stay valid),
+         * e.g. before the thread exits, so another thread can claim it */
+        void detach();
+
+        /* Occupancy of arena i (see stalloc_occ_t) */
+        stalloc_occ_t occupancy(const size_t i) const;
+
+        /* Check if a block is held by one of the arenas */
+        bool owns(const void* const p) { return find(p) != nullptr; }
+
+        /* Arena i. Not synchronized (e.g. for printb() when idle) */
+        A& arena(const size_t i) { return m_slots[i].arena; }
+};
+
+/**
+ * stalloc_pool_t::lock()
+ *
+ * Acquire the spinlock guarding an arena. Spins on a plain load so
+ * that waiting threads do not bounce the cache line between cores.
+ */
+template<typename A, typename T, size_t Arenas>
+void stalloc_pool_t<A, T, Arenas>::lock(slot_t& s) {
+    while (s.lock.test_and_set(std::memory_order_acquire)) {
+        while (s.lock.test(std::memory_order_relaxed))
+            std::this_thread::yield();
+    }
+}
+
+/**
+ * stalloc_pool_t::local()
+ *
+ * Get the calling thread's arena, claiming an unowned one on first
+ * use. Returns nullptr if all arenas are owned by other threads, in
+ * which case the calling thread always steals.
+ */
+template<typename A, typename T, size_t Arenas>
+typename stalloc_pool_t<A, T, Arenas>::slot_t*
+stalloc_pool_t<A, T, Arenas>::local() {
+    const std::thread::id self = std::this_thread::get_id();
+
+    /* Fast path, same pool as last call (owner rechecked in case another
+     * pool has since been constructed at the same address) */
+    if (t_memo.pool == this && t_memo.slot->owner.load(std::memory_order_relaxed) == self)
+        return t_memo.slot;
+
+    for (slot_t& s : m_slots) {
+        std::thread::id owner = s.owner.load(std::memory_order_relaxed);
+        if (owner == self || (owner == std::thread::id() && s.owner.compare_exchange_strong(owner, self))) {
+            t_memo = {this, &s};
+            return &s;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * stalloc_pool_t::find()
+ *
+ * Get the arena holding a block, by the arena's own owns() where
+ * it has one (e.g. when its buffer is external), otherwise by the
+ * block's address within the pool. Returns nullptr for blocks of
+ * no arena.
+ */
+template<typename A, typename T, size_t Arenas>
+typename stalloc_pool_t<A, T, Arenas>::slot_t*
+stalloc_pool_t<A, T, Arenas>::find(const void* const p) {
+    if constexpr (requires (A& a) { a.owns(p); }) {
+        for (slot_t& s : m_slots) {
+            if (s.arena.owns(p))
+                return &s;
+        }
+        return nullptr;
+    } else {
+        const size_t off = (size_t)p - (size_t)m_slots;
+        if (off >= sizeof(m_slots) || off % sizeof(slot_t) >= sizeof(A))
+            return nullptr;
+        return &m_slots[off / sizeof(slot_t)];
+    }
+}
+
+/**
+ * stalloc_pool_t::try_alloc()
+ *
+ * Allocate from one arena under its lock, accounting the block's
+ * usable size to the arena's occupancy.
+ */
+template<typename A, typename T, size_t Arenas>
+void* stalloc_pool_t<A, T, Arenas>::try_alloc(slot_t& s, const size_t size) {
+    lock(s);
+    const AT bp = s.arena.alloc(size);
+    if (bp)
+        s.used.store(s.used.load(std::memory_order_relaxed) + s.arena.usable_size(bp), std::memory_order_relaxed);
+    unlock(s);
+
+    return static_cast<void*>(bp);
+}
+
+/**
+ * stalloc_pool_t::steal()
+ *
+ * Serve a request the calling thread's arena (self, or nullptr if
+ * it has none) could not. The sibling with the fewest bytes in use
+ * is tried first, then the others in order. Kept out of line so
+ * that alloc() stays small.
+ */
+template<typename A, typename T, size_t Arenas>
+T* stalloc_pool_t<A, T, Arenas>::steal(slot_t* const self, const size_t size) {
+    slot_t* best = nullptr;
+    for (slot_t& s : m_slots) {
+        if (&s != self && (!best || s.used.load(std::memory_order_relaxed) < best->used.load(std::memory_order_relaxed)))
+            best = &s;
+    }
+
+    if (!best)
+        return nullptr;
+
+    void* bp = try_alloc(*best, size);
+    if (bp) {
+        best->steals.fetch_add(1, std::memory_order_relaxed);
+        return static_cast<T*>(bp);
+    }
+
+    for (slot_t& s : m_slots) {
+        if (&s == self || &s == best)
+            continue;
+
+        if ((bp = try_alloc(s, size))) {
+            s.steals.fetch_add(1, std::memory_order_relaxed);
+            return static_cast<T*>(bp);
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * stalloc_pool_t::alloc()
+ *
+ * Public facing allocation subroutine. Attempts to allocate from
+ * the calling thread's arena, stealing from a sibling on failure.
+ * Returns nullptr if no arena can serve the request.
+ */
+template<typename A, typename T, size_t Arenas>
+T* stalloc_pool_t<A, T, Arenas>::alloc(const size_t size) {
+    /* Ignore zero-sized requests */
+    if (!size)
+        return nullptr;
+
+    slot_t* const self = local();
+    if (self) [[likely]] {
+        void* const bp = try_alloc(*self, size);
+        if (bp)
+            return static_cast<T*>(bp);
+    }
+    return steal(self, size);
+}
+
+/**
+ * stalloc_pool_t::free()
+ *
+ * Public facing de-allocation subroutine. Returns the block to the
+ * arena it was allocated from, whichever thread frees it. Silently
+ * fails if given an invalid request.
+ */
+template<typename A, typename T, size_t Arenas>
+void stalloc_pool_t<A, T, Arenas>::free(T* const bp) {
+    void* const vbp = static_cast<void*>(bp);
+    slot_t* const s = vbp ? find(vbp) : nullptr;
+
+    /* Ignore invalid requests */
+    if (!s)
+        return;
+
+    lock(*s);
+    const size_t usize = s->arena.usable_size(static_cast<AT>(vbp));
+    s->used.store(s->used.load(std::memory_order_relaxed) - usize, std::memory_order_relaxed);
+    s->arena.free(static_cast<AT>(vbp));
+    unlock(*s);
+}
+
+/**
+ * stalloc_pool_t::detach()
+ *
+ * Release the calling thread's claim on its arena. Blocks already
+ * allocated from it stay valid and may be freed by any thread.
+ */
+template<typename A, typename T, size_t Arenas>
+void stalloc_pool_t<A, T, Arenas>::detach() {
+    const std::thread::id self = std::this_thread::get_id();
+
+    for (slot_t& s : m_slots) {
+        std::thread::id owner = self;
+        if (s.owner.compare_exchange_strong(owner, std::thread::id()))
+            break;
+    }
+    if (t_memo.pool == this)
+        t_memo = {nullptr, nullptr};
+}
+
+/**
+ * stalloc_pool_t::occupancy()
+ *
+ * Returns a snapshot of the occupancy of arena i. The capacity is
+ * the arena's size() where it has one, otherwise its object size.
+ */
+template<typename A, typename T, size_t Arenas>
+stalloc_occ_t stalloc_pool_t<A, T, Arenas>::occupancy(const size_t i) const {
+    const slot_t& s = m_slots[i];
+    stalloc_occ_t occ;
+
+    occ.used = s.used.load(std::memory_order_relaxed);
+    if constexpr (requires (const A& a) { a.size(); })
+        occ.capacity = s.arena.size();
+    else
+        occ.capacity = sizeof(A);
+    occ.steals = s.steals.load(std::memory_order_relaxed);
+    occ.owned = (s.owner.load(std::memory_order_relaxed) != std::thread::id());
+    return occ;
+}
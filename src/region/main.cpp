@@ -0,0 +1,107 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include "../explist/stalloc.hpp"
+#include "region.hpp"
+
+#define pr_inf "inf[" << __func__ << "]: "
+#define pr_err "err[" << __func__ << "]: "
+
+/* 64MB arena over a mapped region */
+constexpr size_t ARENA = (size_t)64 << 20;
+using mapped_t = stalloc_t<ARENA, int, stalloc_fit_t::best_fit, stalloc_ord_t::seg_order, stalloc_ftr_t::keep_ftrs,
+                           stalloc_tag_t::wide_tags, stalloc_coa_t::eager_coalesce, stalloc_mem_t::mapped_mem>;
+
+int main() {
+    const size_t pg = (size_t)sysconf(_SC_PAGESIZE);
+
+    /* Plain mapping: page aligned, zeroed and writable */
+    std::cout << std::endl << pr_inf << "mapping a 1MB region" << std::endl;
+    {
+        stalloc_region_t r(1 << 20);
+        assert(r.data() && ((size_t)r.data() & (pg - 1)) == 0 && r.size() == (1 << 20));
+        assert(!r.huge() && !r.bound());
+        assert(r.data()[0] == 0 && r.data()[(1 << 20) - 1] == 0);
+        r.data()[(1 << 20) - 1] = 1;
+
+        /* Ownership moves with the region */
+        stalloc_region_t m(std::move(r));
+        assert(!r.data() && m.data()[(1 << 20) - 1] == 1);
+    }
+
+    /* Huge pages fall back to normal pages when none are reserved */
+    std::cout << pr_inf << "mapping a 4MB region with huge pages, pre-faulted" << std::endl;
+    {
+        stalloc_region_t r(4 << 20, {.huge = true, .populate = true});
+        assert(r.data());
+        std::cout << pr_inf << "huge pages: " << (r.huge() ? "yes" : "no (fallback)") << std::endl;
+    }
+
+    /* Binding fails without NUMA support, the region is usable regardless */
+    std::cout << pr_inf << "mapping a 4MB region bound to node 0, pre-faulted" << std::endl;
+    {
+        stalloc_region_t r(4 << 20, {.node = 0, .populate = true});
+        assert(r.data() && r.data()[(4 << 20) - 1] == 0);
+        std::cout << pr_inf << "bound to node 0: " << (r.bound() ? "yes" : "no") << std::endl;
+    }
+
+    /* An out of range node is never bound */
+    {
+        stalloc_region_t r(pg, {.node = 64});
+        assert(r.data() && !r.bound());
+    }
+
+    /* Allocator over a mapped region, too large for the thread stack */
+    std::cout << std::endl << pr_inf << "allocating from a 64MB mapped arena" << std::endl;
+    mapped_t st({.huge = true, .populate = true});
+    assert(st.region().data() && st.region().size() == ARENA);
+
+    int* i = st.alloc(ARENA - 32);
+    assert(i && st.owns(i) && !st.owns(&st));
+    i[0] = 1;
+    i[(ARENA - 32) / sizeof(int) - 1] = 2;
+    assert(!st.alloc(4));
+    st.free(i);
+    i = nullptr;
+
+    /* Allocate 16,384 4000B blocks, free every other one, refill the holes */
+    static int* buf[16384] = {nullptr};
+    for (int idx = 0; idx < 16384; idx++) {
+        buf[idx] = st.alloc(1000 * sizeof(int));
+        assert(buf[idx] && st.owns(buf[idx]));
+        buf[idx][999] = idx;
+    }
+    for (int idx = 0; idx < 16384; idx += 2) {
+        st.free(buf[idx]);
+        buf[idx] = nullptr;
+    }
+    for (int idx = 0; idx < 16384; idx += 2) {
+        buf[idx] = st.alloc(1000 * sizeof(int));
+        assert(buf[idx] && buf[idx + 1][999] == idx + 1);
+    }
+    for (int idx = 0; idx < 16384; idx++) {
+        st.free(buf[idx]);
+        buf[idx] = nullptr;
+    }
+    assert(st.can_alloc(ARENA - 32));
+
+    /* Same pattern over the whole arena, pages already faulted in */
+    std::cout << std::endl << pr_inf << "running performance test (64 loops)..." << std::endl;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int l = 0; l < 64; l++) {
+        for (int idx = 0; idx < 16384; idx++) {
+            buf[idx] = st.alloc(1000 * sizeof(int));
+            assert(buf[idx]);
+            buf[idx][0] = idx;
+        }
+        for (int idx = 0; idx < 16384; idx++) {
+            st.free(buf[idx]);
+            buf[idx] = nullptr;
+        }
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "performance test done [" << dur_time.count() / 1000. << "s]" << std::endl;
+
+    return 0;
+}
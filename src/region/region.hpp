@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+
+/**
+ * stalloc_map_opts_t
+ *
+ * Placement options of a stalloc_region_t.
+ */
+struct stalloc_map_opts_t {
+    bool huge = false;      /* Back the region with huge pages (MAP_HUGETLB) */
+    int node = -1;          /* NUMA node to bind the region to (-1 for none) */
+    bool populate = false;  /* Pre-fault every page when the region is created */
+};
+
+/**
+ * stalloc_region_t
+ *
+ * Anonymous memory mapping owned for the lifetime of the object,
+ * used as the buffer of allocators with mapped storage.
+ *
+ * With huge set, huge pages are requested first. If none are
+ * reserved (or the platform has no MAP_HUGETLB), normal pages are
+ * mapped instead and marked for transparent huge pages; huge()
+ * tells which. With a node, the pages are bound to it with mbind()
+ * before they are faulted in, so pre-faulted pages land there;
+ * bound() is false if binding failed (e.g. no NUMA support). With
+ * populate, every page is faulted in up front, so that first touch
+ * page faults do not hit the allocation path.
+ *
+ * data() is nullptr if the mapping failed.
+ */
+class stalloc_region_t {
+    /* Huge page size assumed for rounding MAP_HUGETLB mappings */
+    static constexpr size_t HUGE_SIZE = (size_t)2 << 20;
+
+    /* mbind() policy and flags, from <numaif.h> (which needs libnuma) */
+    static constexpr int MPOL_BIND_ = 2;
+    static constexpr unsigned MPOL_MF_MOVE_ = 1 << 1;
+
+    private:
+        unsigned char* m_data = nullptr;
+        size_t m_size = 0;
+        size_t m_len = 0;
+        bool m_huge = false;
+        bool m_bound = false;
+
+        void* map(const size_t len, const int flags) {
+            void* const p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+            return (p == MAP_FAILED) ? nullptr : p;
+        }
+
+        bool bind(const int node) {
+#ifdef SYS_mbind
+            if (node < 0 || node >= 64)
+                return false;
+            const unsigned long mask = 1ul << node;
+            return !syscall(SYS_mbind, m_data, m_len, MPOL_BIND_, &mask, 64ul, MPOL_MF_MOVE_);
+#else
+            (void)node;
+            return false;
+#endif
+        }
+
+    public:
+        stalloc_region_t(const size_t size, const stalloc_map_opts_t& opts = {}) : m_size(size) {
+            const size_t pg = (size_t)sysconf(_SC_PAGESIZE);
+
+            /* Pre-fault in mmap() itself unless pages must be bound first */
+            const int populate = (opts.populate && opts.node < 0) ? MAP_POPULATE : 0;
+
+#ifdef MAP_HUGETLB
+            if (opts.huge) {
+                m_len = (size + HUGE_SIZE - 1) & ~(HUGE_SIZE - 1);
+                m_data = static_cast<unsigned char*>(map(m_len, MAP_HUGETLB | populate));
+                m_huge = (m_data != nullptr);
+            }
+#endif
+            if (!m_data) {
+                m_len = (size + pg - 1) & ~(pg - 1);
+                m_data = static_cast<unsigned char*>(map(m_len, populate));
+                if (!m_data)
+                    return;
+#ifdef MADV_HUGEPAGE
+                if (opts.huge)
+                    madvise(m_data, m_len, MADV_HUGEPAGE);
+#endif
+            }
+
+            if (opts.node >= 0) {
+                m_bound = bind(opts.node);
+
+                /* Fault pages in on the node they are now bound to */
+                if (opts.populate) {
+                    for (size_t off = 0; off < m_len; off += pg)
+                        static_cast<volatile unsigned char*>(m_data)[off] = 0;
+                }
+            }
+        }
+
+        ~stalloc_region_t() {
+            if (m_data)
+                munmap(m_data, m_len);
+        }
+
+        stalloc_region_t(const stalloc_region_t&) = delete;
+        stalloc_region_t& operator=(const stalloc_region_t&) = delete;
+
+        stalloc_region_t(stalloc_region_t&& r) noexcept
+            : m_data(std::exchange(r.m_data, nullptr)), m_size(r.m_size), m_len(r.m_len),
+              m_huge(r.m_huge), m_bound(r.m_bound) {}
+
+        /* Start and (requested) size of the region */
+        unsigned char* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+        /* Check if the region is backed by huge pages, and bound to its node */
+        bool huge() const { return m_huge; }
+        bool bound() const { return m_bound; }
+};
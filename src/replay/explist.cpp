@@ -0,0 +1,23 @@
+#include "../explist/stalloc.hpp"
+#include "replay.hpp"
+
+void replay_explist(const replay_trace_t& tr) {
+    replay_run<stalloc_t<REPLAY_ARENA, void, stalloc_fit_t::first_fit,
+                         stalloc_ord_t::lifo_order>>("explist first_fit lifo", tr);
+    replay_run<stalloc_t<REPLAY_ARENA, void, stalloc_fit_t::first_fit,
+                         stalloc_ord_t::addr_order>>("explist first_fit addr", tr);
+    replay_run<stalloc_t<REPLAY_ARENA, void, stalloc_fit_t::first_fit,
+                         stalloc_ord_t::addr_order, stalloc_ftr_t::keep_ftrs, stalloc_tag_t::wide_tags,
+                         stalloc_coa_t::lazy_coalesce>>("explist addr lazy", tr);
+    replay_run<stalloc_t<REPLAY_ARENA, void, stalloc_fit_t::best_fit,
+                         stalloc_ord_t::lifo_order>>("explist best_fit lifo", tr);
+    replay_run<stalloc_t<REPLAY_ARENA, void, stalloc_fit_t::best_fit,
+                         stalloc_ord_t::addr_order>>("explist best_fit addr", tr);
+    replay_run<stalloc_t<REPLAY_ARENA, void, stalloc_fit_t::first_fit,
+                         stalloc_ord_t::seg_order>>("explist first_fit seg", tr);
+    replay_run<stalloc_t<REPLAY_ARENA, void, stalloc_fit_t::first_fit,
+                         stalloc_ord_t::seg_order, stalloc_ftr_t::keep_ftrs,
+                         stalloc_tag_t::compact_tags>>("explist seg compact", tr);
+    replay_run<stalloc_t<REPLAY_ARENA, void, stalloc_fit_t::best_fit,
+                         stalloc_ord_t::seg_order>>("explist best_fit seg", tr);
+}
@@ -0,0 +1,7 @@
+#include "../implist/stalloc.hpp"
+#include "replay.hpp"
+
+void replay_implist(const replay_trace_t& tr) {
+    replay_run<stalloc_t<REPLAY_ARENA, void, stalloc_fit_t::first_fit>>("implist first_fit", tr);
+    replay_run<stalloc_t<REPLAY_ARENA, void, stalloc_fit_t::best_fit>>("implist best_fit", tr);
+}
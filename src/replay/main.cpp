@@ -0,0 +1,61 @@
+#include <iostream>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "replay.hpp"
+
+#define pr_inf "inf[" << __func__ << "]: "
+#define pr_err "err[" << __func__ << "]: "
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << pr_err << "usage: " << argv[0] << " <trace file>" << std::endl;
+        return 1;
+    }
+
+    /* Map the whole trace file, records are replayed straight from the mapping */
+    const int fd = open(argv[1], O_RDONLY);
+    struct stat sb;
+    if (fd < 0 || fstat(fd, &sb) < 0) {
+        std::cerr << pr_err << "cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    const size_t len = sb.st_size;
+    void* const map = (len >= sizeof(stalloc_trace_hdr_t)) ? mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0)
+                                                           : MAP_FAILED;
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << pr_err << "cannot map " << argv[1] << std::endl;
+        return 1;
+    }
+
+    const replay_trace_t tr = {static_cast<const stalloc_trace_hdr_t*>(map),
+                               reinterpret_cast<const stalloc_rec_t*>(static_cast<const char*>(map) +
+                                                                      sizeof(stalloc_trace_hdr_t))};
+
+    if (memcmp(tr.hdr->magic, "STTR", 4) || tr.hdr->version != stalloc_trace_t::VERSION ||
+        tr.hdr->count > (len - sizeof(stalloc_trace_hdr_t)) / sizeof(stalloc_rec_t)) {
+        std::cerr << pr_err << argv[1] << " is not a valid trace file" << std::endl;
+        munmap(map, len);
+        return 1;
+    }
+
+    std::cout << std::endl << pr_inf << "replaying " << tr.hdr->count << " records ("
+              << tr.hdr->dropped << " dropped) traced on a " << tr.hdr->arena << "B arena against "
+              << REPLAY_ARENA << "B arenas..." << std::endl;
+    if (tr.hdr->arena != REPLAY_ARENA)
+        std::cout << pr_inf << "arena sizes differ, rebuild with make replay ARENA="
+                  << tr.hdr->arena << " to reproduce the traced failures" << std::endl;
+    std::cout << std::endl;
+
+    replay_header();
+    replay_implist(tr);
+    replay_explist(tr);
+    replay_tlsf(tr);
+
+    munmap(map, len);
+    return 0;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <unordered_map>
+#include "../trace/trace.hpp"
+
+/* Arena size of every replayed stalloc_t configuration (bytes). Should
+ * match the traced allocator (set with make replay ARENA=...) */
+#ifndef REPLAY_ARENA
+#define REPLAY_ARENA 1048576
+#endif
+
+/* Minimum replay time per configuration. Short traces are replayed
+ * repeatedly (from an empty arena) until it is reached */
+inline constexpr double REPLAY_MIN_TIME = 0.25;
+
+/* A memory-mapped trace file */
+struct replay_trace_t {
+    const stalloc_trace_hdr_t* hdr;
+    const stalloc_rec_t* recs;
+};
+
+/* Per-configuration entry points, one translation unit each (every
+ * implementation names its class stalloc_t) */
+void replay_implist(const replay_trace_t& tr);
+void replay_explist(const replay_trace_t& tr);
+void replay_tlsf(const replay_trace_t& tr);
+
+/* Outcome of one pass over the trace */
+struct replay_stats_t {
+    size_t fails = 0;
+    size_t unmatched = 0;
+    size_t live = 0;
+    size_t peak = 0;
+
+    /* First failed allocation: record index, request size and live bytes */
+    size_t ffail_idx = SIZE_MAX;
+    size_t ffail_size = 0;
+    size_t ffail_live = 0;
+};
+
+/* Live block of the replayed arena and its request size */
+struct replay_blk_t {
+    void* p;
+    uint32_t size;
+};
+
+/* Live blocks keyed by traced handle. Handles are block offsets of the
+ * traced allocator, whose alignment the trace does not record */
+using replay_live_t = std::unordered_map<uint32_t, replay_blk_t>;
+
+/**
+ * replay_pass()
+ *
+ * Replay every record of the trace against arena a, which must be
+ * empty, and leave it empty again. Handles of the traced allocator
+ * are mapped to blocks of a through the live table.
+ *
+ * Frees of handles that are not live are counted as unmatched and
+ * skipped (their allocation was dropped from the ring buffer, or
+ * failed during this replay).
+ * Allocations that failed when traced are retried and, if they
+ * succeed, released immediately.
+ */
+template<typename A>
+replay_stats_t replay_pass(A& a, const replay_trace_t& tr, replay_live_t& live) {
+    replay_stats_t rs;
+
+    for (size_t n = 0; n < tr.hdr->count; n++) {
+        const stalloc_rec_t& rec = tr.recs[n];
+
+        if (rec.op == free_op) {
+            const replay_live_t::iterator it = live.find(rec.handle);
+            if (it == live.end()) {
+                rs.unmatched++;
+                continue;
+            }
+            a.free(it->second.p);
+            rs.live -= it->second.size;
+            live.erase(it);
+            continue;
+        }
+
+        void* const p = a.alloc(rec.size);
+        if (!p) {
+            if (!rs.fails++) {
+                rs.ffail_idx = n;
+                rs.ffail_size = rec.size;
+                rs.ffail_live = rs.live;
+            }
+        } else if (rec.handle == stalloc_trace_t::NO_HANDLE) {
+            a.free(p);
+        } else {
+            replay_blk_t& blk = live[rec.handle];
+            if (blk.p) {
+                a.free(blk.p);
+                rs.live -= blk.size;
+            }
+            blk = {p, rec.size};
+            rs.live += rec.size;
+            rs.peak = (rs.live > rs.peak) ? rs.live : rs.peak;
+        }
+    }
+
+    for (const auto& [handle, blk] : live)
+        a.free(blk.p);
+    live.clear();
+    return rs;
+}
+
+/**
+ * replay_run()
+ *
+ * Replay the trace against a fresh instance of stalloc_t configuration
+ * A (instantiated with T = void) and report its throughput, failures
+ * and first failure point.
+ */
+template<typename A>
+void replay_run(const char* name, const replay_trace_t& tr) {
+    std::unique_ptr<A> a = std::make_unique<A>();
+    replay_live_t live;
+    live.reserve(tr.hdr->count);
+
+    /* Failures are reported from the first pass, every pass is identical */
+    const replay_stats_t rs = replay_pass(*a, tr, live);
+
+    size_t passes = 0;
+    double dur = 0;
+    auto start_time = std::chrono::steady_clock::now();
+    while (dur < REPLAY_MIN_TIME) {
+        (void)replay_pass(*a, tr, live);
+        passes++;
+        dur = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    printf("%-26s %10.2f %8zu %10zu %9zu", name, passes * tr.hdr->count / dur / 1e6, rs.fails,
+           rs.peak >> 10, rs.unmatched);
+    if (rs.fails)
+        printf("   #%zu (%zuB, %zuKB live)\n", rs.ffail_idx, rs.ffail_size, rs.ffail_live >> 10);
+    else
+        printf("   -\n");
+}
+
+/* Print the table header */
+inline void replay_header() {
+    printf("%-26s %10s %8s %10s %9s   %s\n",
+           "Configuration", "Mops/s", "fails", "peak KB", "unmatched", "first failure");
+    printf("%-26s %10s %8s %10s %9s   %s\n",
+           "-------------", "------", "-----", "-------", "---------", "-------------");
+}
@@ -0,0 +1,6 @@
+#include "../tlsf/stalloc.hpp"
+#include "replay.hpp"
+
+void replay_tlsf(const replay_trace_t& tr) {
+    replay_run<stalloc_t<REPLAY_ARENA>>("tlsf", tr);
+}
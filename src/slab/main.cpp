@@ -0,0 +1,169 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include "../explist/stalloc.hpp"
+#include "slab.hpp"
+
+#define pr_inf "inf[" << __func__ << "]: "
+#define pr_err "err[" << __func__ << "]: "
+
+int main() {
+    stalloc_slab_t<stalloc_t<4096>, int> st;
+
+    int* i = nullptr;
+    int* j = nullptr;
+    int* k = nullptr;
+
+    /* Allocate three 16B blocks. These should be adjacent slots of one slab */
+    std::cout << std::endl << pr_inf << "allocating three 16B blocks" << std::endl;
+    i = st.alloc(4 * sizeof(int));
+    j = st.alloc(4 * sizeof(int));
+    k = st.alloc(4 * sizeof(int));
+    st.prints();
+    assert(i && j && k);
+    assert(j == i + 4 && k == j + 4);
+
+    /* Freed slots are reused first */
+    std::cout << std::endl << pr_inf << "freeing j (" << j << ") and re-allocating it" << std::endl;
+    st.free(j);
+    assert(st.alloc(4 * sizeof(int)) == j);
+
+    std::cout << pr_inf << "freeing i, j and k" << std::endl;
+    st.free(i);
+    st.free(j);
+    st.free(k);
+    i = j = k = nullptr;
+    st.prints();
+
+    /* Requests above SlabMax bypass the slabs */
+    std::cout << std::endl << pr_inf << "allocating a 256B block (backing allocator)" << std::endl;
+    i = st.alloc(64 * sizeof(int));
+    assert(i);
+    st.arena().printb();
+    st.free(i);
+    i = nullptr;
+
+    /* Once empty slabs are trimmed the whole buffer is available again */
+    std::cout << std::endl << pr_inf << "trimming and allocating block of max size" << std::endl;
+    st.trim();
+    i = st.alloc(1016 * sizeof(int));
+    st.arena().printb();
+    assert(i);
+    st.free(i);
+    i = nullptr;
+
+    /* Without slabs 126 16B blocks fill the buffer. Slabs should fit well over 1.5x as many */
+    std::cout << std::endl << pr_inf << "allocating 16B blocks until the buffer is full" << std::endl;
+    int* abuf[512] = {nullptr};
+    int cnt = 0;
+    for (; cnt < 512; cnt++) {
+        if (!(abuf[cnt] = st.alloc(4 * sizeof(int))))
+            break;
+    }
+    std::cout << pr_inf << "allocated " << cnt << " 16B blocks" << std::endl;
+    assert(cnt > 126 * 3 / 2);
+
+    /* Free every second block, then the rest from last to first */
+    std::cout << pr_inf << "freeing every second block, then the rest from last to first" << std::endl;
+    for (int idx = 1; idx < cnt; idx += 2) {
+        st.free(abuf[idx]);
+        abuf[idx] = nullptr;
+    }
+    for (int idx = (cnt - 1) & ~1; idx >= 0; idx -= 2) {
+        st.free(abuf[idx]);
+        abuf[idx] = nullptr;
+    }
+    st.trim();
+    st.arena().printb();
+
+    /* Allocate mixed small classes, free them, and check the buffer is whole again */
+    std::cout << std::endl << pr_inf << "allocating blocks of every small size class" << std::endl;
+    int* bbuf[64];
+    for (int idx = 0; idx < 64; idx++) {
+        bbuf[idx] = st.alloc(1 + idx);
+        assert(bbuf[idx]);
+        assert(((size_t)bbuf[idx] & (2 * sizeof(void*) - 1)) == 0);
+    }
+    st.prints();
+    for (int idx = 0; idx < 64; idx++) {
+        st.free(bbuf[idx]);
+        bbuf[idx] = nullptr;
+    }
+    st.trim();
+    i = st.alloc(1016 * sizeof(int));
+    assert(i);
+    st.free(i);
+    i = nullptr;
+
+    /* Compact tag arenas only align blocks to 4 or 8 bytes, slabs carved out of them must still be aligned */
+    std::cout << std::endl << pr_inf << "allocating every small size class over a compact tag arena" << std::endl;
+    stalloc_slab_t<stalloc_t<8192, void, stalloc_fit_t::first_fit, stalloc_ord_t::lifo_order,
+                              stalloc_ftr_t::keep_ftrs, stalloc_tag_t::compact_tags>, int> cst;
+    void* cp = cst.arena().alloc(4);
+    assert(cp && ((size_t)cp & (2 * sizeof(void*) - 1)));
+    for (int idx = 0; idx < 64; idx++) {
+        bbuf[idx] = cst.alloc(1 + idx);
+        assert(bbuf[idx]);
+        assert(((size_t)bbuf[idx] & (2 * sizeof(void*) - 1)) == 0);
+    }
+    cst.prints();
+    for (int idx = 0; idx < 64; idx++) {
+        cst.free(bbuf[idx]);
+        bbuf[idx] = nullptr;
+    }
+    cst.trim();
+    cst.arena().free(cp);
+    cp = nullptr;
+    cst.arena().printb();
+
+    /* Allocate and free 126 16B blocks many times, with and without slabs */
+    std::cout << std::endl << pr_inf << "running performance test (65,536 loops)..." << std::endl;;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int l = 0; l < 65536; l++) {
+        for (int idx = 0; idx < 126; idx++) {
+            abuf[idx] = st.alloc(4 * sizeof(int));
+            assert(abuf[idx]);
+        }
+        i = st.alloc(8 * sizeof(int));
+        assert(i);
+        for (int idx = 1; idx < 126; idx += 2) {
+            st.free(abuf[idx]);
+            abuf[idx] = nullptr;
+        }
+        st.free(i);
+        i = nullptr;
+        for (int idx = 124; idx >= 0; idx -= 2) {
+            st.free(abuf[idx]);
+            abuf[idx] = nullptr;
+        }
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "performance test done [" << dur_time.count() / 1000. << "s]" << std::endl;
+
+    stalloc_t<4096, int> bst;
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int l = 0; l < 65536; l++) {
+        for (int idx = 0; idx < 126; idx++) {
+            abuf[idx] = bst.alloc(4 * sizeof(int));
+            assert(abuf[idx]);
+        }
+        i = bst.alloc(8 * sizeof(int));
+        assert(i);
+        for (int idx = 1; idx < 126; idx += 2) {
+            bst.free(abuf[idx]);
+            abuf[idx] = nullptr;
+        }
+        bst.free(i);
+        i = nullptr;
+        for (int idx = 124; idx >= 0; idx -= 2) {
+            bst.free(abuf[idx]);
+            abuf[idx] = nullptr;
+        }
+    }
+    end_time = std::chrono::high_resolution_clock::now();
+    dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "performance test done without slabs [" << dur_time.count() / 1000. << "s]" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+#include <utility>
+
+/**
+ * stalloc_slab_t
+ *
+ * Fixed-size slab front-end for any stalloc_t (A, instantiated with
+ * T = void). Requests of at most SlabMax bytes are served from slabs:
+ * SlabSize byte blocks carved out of the backing allocator, each split
+ * into up to 64 equal slots of one DSIZE multiple size class. Slot
+ * occupancy is tracked in a per-slab bitmap, so a free slot is found
+ * with a single bit scan and small objects pay no boundary tags.
+ * Larger requests (or small ones when no slab can be carved) fall
+ * through to the backing allocator.
+ */
+template<typename A, typename T = void, size_t SlabSize = 512, size_t SlabMax = 64>
+class stalloc_slab_t {
+    /* Word and double-word sizes, architecture dependant (bytes) */
+    static constexpr size_t WSIZE = sizeof(void*);
+    static constexpr size_t DSIZE = 2 * WSIZE;
+
+    /* Alignment helpers */
+    static constexpr size_t ALIGN_MASK(size_t x, size_t m) { return (x + m) & (~m); }
+    static constexpr size_t ALIGN_UP(size_t x) { return ALIGN_MASK(x, DSIZE-1); }
+
+    /* Slab header, stored at the start of every slab */
+    struct slab_t {
+        slab_t* prev;
+        slab_t* next;
+        uint64_t fmap;
+        size_t csize;
+    };
+
+    /* Size classes are DSIZE apart: class i holds slots of (i + 1) * DSIZE bytes */
+    static constexpr size_t SLAB_HDR = ALIGN_UP(sizeof(slab_t));
+    static constexpr size_t CL_COUNT = SlabMax / DSIZE;
+    static constexpr size_t CL_INDEX(size_t size) { return (size - 1) / DSIZE; }
+    static constexpr size_t CL_SIZE(size_t cls) { return (cls + 1) * DSIZE; }
+
+    /* Number of slots in a slab of the given class, and its all-free bitmap */
+    static constexpr size_t SLOTS(size_t cls) { return ((SlabSize - SLAB_HDR) / CL_SIZE(cls) < 64) ? (SlabSize - SLAB_HDR) / CL_SIZE(cls) : 64; }
+    static constexpr uint64_t FULL_MAP(size_t cls) { return (SLOTS(cls) == 64) ? ~(uint64_t)0 : ((uint64_t)1 << SLOTS(cls)) - 1; }
+
+    /* Get slot area of a slab */
+    static constexpr void* SLOTP(slab_t* sp) { return (void*)((size_t)sp + SLAB_HDR); }
+
+    /* Pointer type handed out by the backing allocator */
+    using AT = decltype(std::declval<A&>().alloc(0));
+
+    /* Ensure T is a trivially copyable type (or void) */
+    static_assert(std::is_trivially_copyable_v<T> || std::is_void_v<T>);
+
+    /* Ensure size classes are double-word aligned and every slab fits at least one slot */
+    static_assert(((SlabMax & (DSIZE-1)) == 0) && (SlabMax > 0));
+    static_assert(((SlabSize & (DSIZE-1)) == 0) && (SlabSize >= SLAB_HDR + SlabMax));
+
+    /* Backing blocks are aligned to less than DSIZE (compact tags), slabs are carved
+     * with alloc_aligned() so that headers and slots stay double-word aligned */
+    static constexpr bool NARROW = requires { requires A::ALIGNMENT < DSIZE; };
+    static_assert(!NARROW || requires (A& a) { a.alloc_aligned(SlabSize, DSIZE); });
+
+    /* Ensure the backing buffer lies within A, slab lookup pages are indexed by offset
+     * from the arena object (allocators with owns() may hold an external or mapped buffer) */
+    static_assert(!requires (const A& a, const void* p) { a.owns(p); } || requires { requires A::INLINE_BUF; });
+
+    /* Slab lookup pages. At most one slab starts in any page since every slab
+     * spans more than SlabSize bytes of the backing buffer */
+    static constexpr size_t PG_COUNT = sizeof(A) / SlabSize + 1;
+
+    private:
+        A m_arena;
+        slab_t* m_slabs[CL_COUNT] = {nullptr};
+        slab_t* m_pages[PG_COUNT] = {nullptr};
+
+        size_t pg_index(void* p) { return ((size_t)p - (size_t)&m_arena) / SlabSize; }
+
+        slab_t* slab_new(const size_t cls);
+        slab_t* slab_find(void* const p);
+        void slab_release(slab_t* const sp);
+
+        void sl_insert(slab_t* const sp);
+        void sl_remove(slab_t* const sp);
+
+    public:
+        [[nodiscard]] T* alloc(const size_t size);
+        void free(T* const bp);
+
+        /* Return all empty slabs to the backing allocator */
+        void trim();
+
+        /* Backing allocator (e.g. for printb()) */
+        A& arena() { return m_arena; }
+
+        /* Debug */
+        void prints();
+};
+
+/**
+ * stalloc_slab_t::prints()
+ *
+ * Print a formatted representation of the partially free slabs
+ * of every size class.
+ */
+template<typename A, typename T, size_t SlabSize, size_t SlabMax>
+void stalloc_slab_t<A, T, SlabSize, SlabMax>::prints() {
+    printf("+------------------------------------------------+\n"
+           "|                      Slabs                     |\n"
+           "+-------+----------------+--------------+--------+\n"
+           "| Class |     Address    |     Slots    |  Free  |\n"
+           "+-------+----------------+--------------+--------+\n");
+
+    for (size_t cls = 0; cls < CL_COUNT; cls++) {
+        for (slab_t* sp = m_slabs[cls]; sp; sp = sp->next) {
+            printf("| %-6ld| %p | %-13ld| %-7d|\n"
+                   "+-------+----------------+--------------+--------+\n",
+                    CL_SIZE(cls), (void*)sp, SLOTS(cls), std::popcount(sp->fmap));
+        }
+    }
+}
+
+/**
+ * stalloc_slab_t::sl_insert()
+ *
+ * Insert slab at the head of its class's list of partially
+ * free slabs.
+ */
+template<typename A, typename T, size_t SlabSize, size_t SlabMax>
+void stalloc_slab_t<A, T, SlabSize, SlabMax>::sl_insert(slab_t* const sp) {
+    slab_t*& slistp = m_slabs[CL_INDEX(sp->csize)];
+
+    sp->prev = nullptr;
+    sp->next = slistp;
+    if (slistp)
+        slistp->prev = sp;
+    slistp = sp;
+}
+
+/**
+ * stalloc_slab_t::sl_remove()
+ *
+ * Remove slab from its class's list of partially free slabs.
+ */
+template<typename A, typename T, size_t SlabSize, size_t SlabMax>
+void stalloc_slab_t<A, T, SlabSize, SlabMax>::sl_remove(slab_t* const sp) {
+    if (sp->prev)
+        sp->prev->next = sp->next;
+    else
+        m_slabs[CL_INDEX(sp->csize)] = sp->next;
+    if (sp->next)
+        sp->next->prev = sp->prev;
+
+    sp->prev = nullptr;
+    sp->next = nullptr;
+}
+
+/**
+ * stalloc_slab_t::slab_new()
+ *
+ * Carve a new slab for the given size class out of the backing
+ * allocator and insert it into the class's list. Returns nullptr
+ * if the backing allocator has no room for another slab. Slabs are
+ * double-word aligned, even over allocators with a smaller block
+ * alignment.
+ */
+template<typename A, typename T, size_t SlabSize, size_t SlabMax>
+typename stalloc_slab_t<A, T, SlabSize, SlabMax>::slab_t*
+stalloc_slab_t<A, T, SlabSize, SlabMax>::slab_new(const size_t cls) {
+    void* vsp;
+    if constexpr (NARROW)
+        vsp = static_cast<void*>(m_arena.alloc_aligned(SlabSize, DSIZE));
+    else
+        vsp = static_cast<void*>(m_arena.alloc(SlabSize));
+    slab_t* const sp = static_cast<slab_t*>(vsp);
+
+    if (!sp)
+        return nullptr;
+
+    sp->fmap = FULL_MAP(cls);
+    sp->csize = CL_SIZE(cls);
+    sl_insert(sp);
+
+    m_pages[pg_index(sp)] = sp;
+    return sp;
+}
+
+/**
+ * stalloc_slab_t::slab_release()
+ *
+ * Return an empty slab to the backing allocator.
+ */
+template<typename A, typename T, size_t SlabSize, size_t SlabMax>
+void stalloc_slab_t<A, T, SlabSize, SlabMax>::slab_release(slab_t* const sp) {
+    sl_remove(sp);
+    m_pages[pg_index(sp)] = nullptr;
+    m_arena.free(static_cast<AT>(static_cast<void*>(sp)));
+}
+
+/**
+ * stalloc_slab_t::slab_find()
+ *
+ * Get the slab owning the given pointer. Only the slabs starting
+ * in the pointer's page and the page before it can hold it.
+ * Returns nullptr for pointers not owned by any slab.
+ */
+template<typename A, typename T, size_t SlabSize, size_t SlabMax>
+typename stalloc_slab_t<A, T, SlabSize, SlabMax>::slab_t*
+stalloc_slab_t<A, T, SlabSize, SlabMax>::slab_find(void* const p) {
+    const size_t pg = pg_index(p);
+
+    for (size_t i = 0; i < 2 && i <= pg && pg - i < PG_COUNT; i++) {
+        slab_t* const sp = m_pages[pg - i];
+        if (sp && (size_t)p >= (size_t)SLOTP(sp) && (size_t)p < (size_t)sp + SlabSize)
+            return sp;
+    }
+    return nullptr;
+}
+
+/**
+ * stalloc_slab_t::trim()
+ *
+ * Return all empty slabs to the backing allocator. The last
+ * slab of each class is otherwise kept to avoid repeatedly
+ * carving and releasing slabs.
+ */
+template<typename A, typename T, size_t SlabSize, size_t SlabMax>
+void stalloc_slab_t<A, T, SlabSize, SlabMax>::trim() {
+    for (size_t cls = 0; cls < CL_COUNT; cls++) {
+        slab_t* sp = m_slabs[cls];
+        while (sp) {
+            slab_t* const next = sp->next;
+            if (sp->fmap == FULL_MAP(cls))
+                slab_release(sp);
+            sp = next;
+        }
+    }
+}
+
+/**
+ * stalloc_slab_t::alloc()
+ *
+ * Public facing allocation subroutine. Requests of at most SlabMax
+ * bytes take the first free slot of the first partially free slab
+ * of their size class, carving a new slab when there is none.
+ * Larger requests, and small ones that cannot get a slab, are
+ * forwarded to the backing allocator. Returns nullptr on failure.
+ *
+ * Slots are always double-word aligned. Forwarded requests get the
+ * backing allocator's block alignment.
+ */
+template<typename A, typename T, size_t SlabSize, size_t SlabMax>
+T* stalloc_slab_t<A, T, SlabSize, SlabMax>::alloc(const size_t size) {
+    /* Ignore zero-sized requests */
+    if (!size)
+        return nullptr;
+
+    if (size <= SlabMax) {
+        const size_t cls = CL_INDEX(size);
+        slab_t* sp = m_slabs[cls];
+
+        if (sp || (sp = slab_new(cls))) {
+            const int slot = std::countr_zero(sp->fmap);
+
+            /* Slab now full, stop offering it */
+            if (!(sp->fmap &= sp->fmap - 1))
+                sl_remove(sp);
+
+            return static_cast<T*>((void*)((size_t)SLOTP(sp) + slot * sp->csize));
+        }
+    }
+
+    return static_cast<T*>(static_cast<void*>(m_arena.alloc(size)));
+}
+
+/**
+ * stalloc_slab_t::free()
+ *
+ * Public facing de-allocation subroutine. Slab slots are marked
+ * free in their slab's bitmap. Empty slabs are returned to the
+ * backing allocator unless they are the last slab of their class.
+ * All other pointers are forwarded to the backing allocator.
+ * Silently fails if given an invalid request.
+ */
+template<typename A, typename T, size_t SlabSize, size_t SlabMax>
+void stalloc_slab_t<A, T, SlabSize, SlabMax>::free(T* const bp) {
+    void* const vbp = static_cast<void*>(bp);
+
+    /* Ignore invalid requests */
+    if (!vbp)
+        return;
+
+    slab_t* const sp = slab_find(vbp);
+    if (!sp) {
+        m_arena.free(static_cast<AT>(vbp));
+        return;
+    }
+
+    const size_t cls = CL_INDEX(sp->csize);
+    const size_t off = (size_t)vbp - (size_t)SLOTP(sp);
+    const size_t slot = off / sp->csize;
+
+    /* Ignore misaligned slot pointers and double frees */
+    if (off % sp->csize || slot >= SLOTS(cls) || (sp->fmap & ((uint64_t)1 << slot)))
+        return;
+
+    /* Slab was full, offer it again */
+    if (!sp->fmap)
+        sl_insert(sp);
+    sp->fmap |= (uint64_t)1 << slot;
+
+    if (sp->fmap == FULL_MAP(cls) && (sp->prev || sp->next))
+        slab_release(sp);
+}
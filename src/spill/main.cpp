@@ -0,0 +1,115 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include "../explist/stalloc.hpp"
+#include "spill.hpp"
+
+#define pr_inf "inf[" << __func__ << "]: "
+#define pr_err "err[" << __func__ << "]: "
+
+int main() {
+    stalloc_spill_t<stalloc_t<4096>, int> st;
+
+    int* i = nullptr;
+    int* j = nullptr;
+    int* k = nullptr;
+
+    /* Requests that fit are served by the stack buffer */
+    std::cout << std::endl << pr_inf << "allocating two 1KB blocks (stack buffer)" << std::endl;
+    i = st.alloc(256 * sizeof(int));
+    j = st.alloc(256 * sizeof(int));
+    assert(i && j && st.owns(i) && st.owns(j));
+    assert(st.spill_stats().spills == 0 && st.spill_stats().rate() == 0);
+
+    /* The buffer cannot fit another 2KB, so it spills to the heap */
+    std::cout << pr_inf << "allocating a 2KB block (spills to the heap)" << std::endl;
+    k = st.alloc(512 * sizeof(int));
+    assert(k && !st.owns(k));
+    for (int x = 0; x < 512; x++)
+        k[x] = x;
+    st.arena().printb();
+
+    const stalloc_spill_stats_t& s = st.spill_stats();
+    std::cout << pr_inf << s.spills << " of " << s.allocs << " allocations spilled (largest "
+              << s.largest << "B, rate " << s.rate() << ")" << std::endl;
+    assert(s.allocs == 3 && s.spills == 1 && s.live == 1 && s.largest == 2048);
+
+    /* Blocks are routed back by address */
+    std::cout << std::endl << pr_inf << "freeing all blocks" << std::endl;
+    assert(k[511] == 511);
+    st.free(i);
+    st.free(j);
+    st.free(k);
+    i = j = k = nullptr;
+    assert(s.live == 0);
+
+    i = st.alloc(1016 * sizeof(int));
+    assert(i && st.owns(i));
+    st.free(i);
+    i = nullptr;
+
+    /* Zero-sized requests fail without spilling */
+    assert(!st.alloc(0) && s.spills == 1);
+
+    /* Spill to freshly mapped pages */
+    std::cout << std::endl << pr_inf << "spilling 16 4KB blocks to mapped pages" << std::endl;
+    stalloc_spill_t<stalloc_t<4096>, int, stalloc_pages_t> pst;
+    int* pbuf[16] = {nullptr};
+    for (int idx = 0; idx < 16; idx++) {
+        pbuf[idx] = pst.alloc(1024 * sizeof(int));
+        assert(pbuf[idx] && !pst.owns(pbuf[idx]) && ((size_t)pbuf[idx] & 15) == 0);
+        pbuf[idx][1023] = idx;
+    }
+    for (int idx = 0; idx < 16; idx++) {
+        assert(pbuf[idx][1023] == idx);
+        pst.free(pbuf[idx]);
+        pbuf[idx] = nullptr;
+    }
+    assert(pst.spill_stats().spills == 16 && pst.spill_stats().live == 0);
+
+    /* Spill to a second, larger stack allocator */
+    std::cout << std::endl << pr_inf << "spilling to a second stalloc_t" << std::endl;
+    stalloc_spill_t<stalloc_t<1024>, int, stalloc_t<16384>> sst;
+    int* sbuf[8] = {nullptr};
+    for (int idx = 0; idx < 8; idx++) {
+        sbuf[idx] = sst.alloc(128 * sizeof(int));
+        assert(sbuf[idx]);
+    }
+    sst.upstream().printb();
+    assert(sst.spill_stats().spills == 7);
+    for (int idx = 0; idx < 8; idx++) {
+        sst.free(sbuf[idx]);
+        sbuf[idx] = nullptr;
+    }
+    assert(sst.spill_stats().live == 0);
+    assert(sst.upstream().can_alloc(16384 - 32));
+
+    /* Stack-resident allocations should cost about the same as without the front-end */
+    std::cout << std::endl << pr_inf << "running performance test (65,536 loops)..." << std::endl;
+    stalloc_t<4096, int> bst;
+    int* abuf[126] = {nullptr};
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int l = 0; l < 65536; l++) {
+        for (int idx = 0; idx < 126; idx++)
+            abuf[idx] = st.alloc(4 * sizeof(int));
+        for (int idx = 0; idx < 126; idx++)
+            st.free(abuf[idx]);
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "stalloc_spill_t done [" << dur_time.count() / 1000. << "s]" << std::endl;
+    assert(s.spills == 1);
+
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int l = 0; l < 65536; l++) {
+        for (int idx = 0; idx < 126; idx++)
+            abuf[idx] = bst.alloc(4 * sizeof(int));
+        for (int idx = 0; idx < 126; idx++)
+            bst.free(abuf[idx]);
+    }
+    end_time = std::chrono::high_resolution_clock::now();
+    dur_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << pr_inf << "stalloc_t done [" << dur_time.count() / 1000. << "s]" << std::endl;
+
+    return 0;
+}
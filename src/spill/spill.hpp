@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+/**
+ * stalloc_heap_t
+ *
+ * Upstream for stalloc_spill_t over malloc()/free().
+ */
+struct stalloc_heap_t {
+    void* alloc(const size_t size) { return std::malloc(size); }
+    void free(void* const p) { std::free(p); }
+};
+
+/**
+ * stalloc_pages_t
+ *
+ * Upstream for stalloc_spill_t mapping fresh anonymous pages for
+ * every request. The mapping length is stored in the double word
+ * preceding the returned pointer, so it stays DSIZE aligned.
+ */
+struct stalloc_pages_t {
+    static constexpr size_t DSIZE = 2 * sizeof(void*);
+
+    void* alloc(const size_t size) {
+        const size_t pg = (size_t)sysconf(_SC_PAGESIZE);
+        const size_t len = (size + DSIZE + pg - 1) & ~(pg - 1);
+        void* const map = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (map == MAP_FAILED)
+            return nullptr;
+
+        *(size_t*)map = len;
+        return (void*)((size_t)map + DSIZE);
+    }
+    void free(void* const p) {
+        void* const map = (void*)((size_t)p - DSIZE);
+        munmap(map, *(size_t*)map);
+    }
+};
+
+/**
+ * stalloc_spill_stats_t
+ *
+ * Spill statistics of a stalloc_spill_t, read with spill_stats().
+ * A high spill rate means MaxSize of the wrapped allocator is too
+ * small for the workload; largest is the biggest request that had
+ * to spill.
+ */
+struct stalloc_spill_stats_t {
+    uint64_t allocs = 0;            /* Successful allocations */
+    uint64_t spills = 0;            /* Allocations served by the upstream */
+    uint64_t spill_bytes = 0;       /* Bytes requested from the upstream */
+    size_t largest = 0;             /* Largest spilled request (bytes) */
+    size_t live = 0;                /* Spilled blocks not yet freed */
+
+    /* Share of allocations served by the upstream */
+    double rate() const { return allocs ? (double)spills / (double)allocs : 0.; }
+};
+
+/**
+ * stalloc_spill_t
+ *
+ * Heap-spilling front-end for any stalloc_t (A, instantiated with
+ * T = void). Requests are served by the wrapped allocator, and only
+ * when it cannot serve them are they forwarded to the upstream U:
+ * stalloc_heap_t (default), stalloc_pages_t, or any other type with
+ * alloc(size) and free(p), such as a second (larger) stalloc_t.
+ *
+ * free() routes blocks by address: pointers inside the wrapped
+ * allocator are returned to it, all others to the upstream.
+ */
+template<typename A, typename T = void, typename U = stalloc_heap_t>
+class stalloc_spill_t {
+    /* Pointer types handed out by the wrapped allocator and upstream */
+    using AT = decltype(std::declval<A&>().alloc(0));
+    using UT = decltype(std::declval<U&>().alloc(0));
+
+    /* Ensure T is a trivially copyable type (or void) */
+    static_assert(std::is_trivially_copyable_v<T> || std::is_void_v<T>);
+
+    private:
+        A m_arena;
+        [[no_unique_address]] U m_upstream;
+        stalloc_spill_stats_t m_spill;
+
+        T* spill(const size_t size);
+
+    public:
+        [[nodiscard]] T* alloc(const size_t size);
+        void free(T* const bp);
+
+        /* Spill statistics (see stalloc_spill_stats_t) */
+        const stalloc_spill_stats_t& spill_stats() const { return m_spill; }
+
+        /* Check if a block is held by the wrapped allocator (by its own
+         * owns() where it has one, e.g. when its buffer is external) */
+        bool owns(const void* const p) const {
+            if constexpr (requires { m_arena.owns(p); })
+                return m_arena.owns(p);
+            else
+                return (size_t)p - (size_t)&m_arena < sizeof(A);
+        }
+
+        /* Wrapped allocator (e.g. for printb()) and upstream */
+        A& arena() { return m_arena; }
+        U& upstream() { return m_upstream; }
+};
+
+/**
+ * stalloc_spill_t::spill()
+ *
+ * Forward a request the wrapped allocator could not serve to the
+ * upstream. Kept out of line so that alloc() stays small.
+ */
+template<typename A, typename T, typename U>
+T* stalloc_spill_t<A, T, U>::spill(const size_t size) {
+    /* Ignore zero-sized requests */
+    if (!size)
+        return nullptr;
+
+    void* const bp = static_cast<void*>(m_upstream.alloc(size));
+    if (!bp)
+        return nullptr;
+
+    m_spill.allocs++;
+    m_spill.spills++;
+    m_spill.spill_bytes += size;
+    m_spill.largest = (size > m_spill.largest) ? size : m_spill.largest;
+    m_spill.live++;
+    return static_cast<T*>(bp);
+}
+
+/**
+ * stalloc_spill_t::alloc()
+ *
+ * Public facing allocation subroutine. Attempts to allocate from
+ * the wrapped allocator, spilling to the upstream on failure.
+ * Returns nullptr if both fail.
+ */
+template<typename A, typename T, typename U>
+T* stalloc_spill_t<A, T, U>::alloc(const size_t size) {
+    void* const bp = static_cast<void*>(m_arena.alloc(size));
+
+    if (bp) [[likely]] {
+        m_spill.allocs++;
+        return static_cast<T*>(bp);
+    }
+    return spill(size);
+}
+
+/**
+ * stalloc_spill_t::free()
+ *
+ * Public facing de-allocation subroutine. Returns the block to
+ * the wrapped allocator if it lies within it, otherwise to the
+ * upstream. Silently fails if given an invalid request.
+ */
+template<typename A, typename T, typename U>
+void stalloc_spill_t<A, T, U>::free(T* const bp) {
+    void* const vbp = static_cast<void*>(bp);
+
+    /* Ignore invalid requests */
+    if (!vbp)
+        return;
+
+    if (owns(vbp)) [[likely]] {
+        m_arena.free(static_cast<AT>(vbp));
+        return;
+    }
+
+    m_upstream.free(static_cast<UT>(vbp));
+    m_spill.live--;
+}
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <cassert>
+#define STALLOC_STATS
+#include "../explist/stalloc.hpp"
+#include "stats.hpp"
+
+#define pr_inf "inf[" << __func__ << "]: "
+#define pr_err "err[" << __func__ << "]: "
+
+/* Print the statistics of an allocator */
+void prints(const stalloc_stats_t& s) {
+    std::cout << pr_inf << "used " << s.used << "B (peak " << s.peak << "B), free " << s.free_bytes << "B in "
+              << s.free_blocks << " blocks (largest " << s.largest << "B, frag " << s.frag() << "), "
+              << s.allocs << " allocs, " << s.frees << " frees, " << s.fails << " fails" << std::endl;
+}
+
+/* Split and merge free blocks of every size, checking that the largest free
+ * block is exact (a block of largest bytes holds largest - 16 bytes), or only
+ * an upper bound for the single freelist */
+template<typename A, bool Exact = true>
+void check_largest() {
+    A st;
+    int* buf[64] = {nullptr};
+
+    for (int r = 0; r < 4; r++) {
+        for (int idx = 0; idx < 64; idx++)
+            buf[idx] = st.alloc(((idx * 37 + r * 11) % 96 + 1) * sizeof(int));
+        for (int idx = r % 2; idx < 64; idx += 2 + r) {
+            st.free(buf[idx]);
+            buf[idx] = nullptr;
+
+            const size_t largest = st.stats().largest;
+            assert(largest && !st.alloc(largest - 15));
+            if constexpr (Exact) {
+                int* const p = st.alloc(largest - 16);
+                assert(p);
+                st.free(p);
+            }
+        }
+        for (int idx = 0; idx < 64; idx++) {
+            st.free(buf[idx]);
+            buf[idx] = nullptr;
+        }
+        assert(st.stats().largest == 16384 - 16);
+    }
+}
+
+int main() {
+    stalloc_t<4096, int, stalloc_fit_t::first_fit, stalloc_ord_t::seg_order> st;
+
+    int* i = nullptr;
+    int* j = nullptr;
+    int* k = nullptr;
+
+    /* A new allocator is one free block of 4080B (class 6: 2KB-4KB) */
+    std::cout << std::endl << pr_inf << "checking statistics of an empty allocator" << std::endl;
+    const stalloc_stats_t& s = st.stats();
+    prints(s);
+    assert(s.used == 0 && s.free_bytes == 4080 && s.free_blocks == 1 && s.largest == 4080);
+    assert(s.classes[6] == 1 && s.frag() == 0);
+
+    /* Three 16B blocks take 32B each */
+    std::cout << std::endl << pr_inf << "allocating three 16B blocks" << std::endl;
+    i = st.alloc(4 * sizeof(int));
+    j = st.alloc(4 * sizeof(int));
+    k = st.alloc(4 * sizeof(int));
+    prints(st.stats());
+    assert(s.used == 96 && s.peak == 96 && s.free_blocks == 1 && s.largest == 3984 && s.allocs == 3);
+
+    /* Freeing j leaves a 32B hole (class 0), fragmenting the free space */
+    std::cout << std::endl << pr_inf << "freeing j (" << j << ")" << std::endl;
+    st.free(j);
+    j = nullptr;
+    prints(st.stats());
+    assert(s.used == 64 && s.peak == 96 && s.free_blocks == 2 && s.classes[0] == 1);
+    assert(s.largest == 3984 && s.frag() == 1. - 3984. / 4016.);
+
+    /* Failed allocations are counted, invalid frees are not */
+    std::cout << std::endl << pr_inf << "trying to allocate 4000B, freeing j again" << std::endl;
+    j = st.alloc(1000 * sizeof(int));
+    assert(!j);
+    st.free(j);
+    prints(st.stats());
+    assert(s.fails == 1 && s.frees == 1);
+
+    /* Allocating the largest block leaves only the hole, the largest block is read back */
+    std::cout << std::endl << pr_inf << "allocating the largest free block" << std::endl;
+    j = st.alloc(3968);
+    assert(j);
+    prints(st.stats());
+    assert(s.used == 4048 && s.peak == 4048 && s.free_blocks == 1 && s.largest == 32 && s.frag() == 0);
+
+    /* Freeing everything coalesces back into one block */
+    std::cout << std::endl << pr_inf << "freeing all blocks" << std::endl;
+    st.free(i);
+    st.free(j);
+    st.free(k);
+    i = j = k = nullptr;
+    prints(st.stats());
+    assert(s.used == 0 && s.free_blocks == 1 && s.largest == 4080 && s.classes[0] == 0 && s.classes[6] == 1);
+    assert(s.allocs == 4 && s.frees == 4 && s.peak == 4048);
+
+    /* Batches count every block, in-place realloc() only moves bytes */
+    std::cout << std::endl << pr_inf << "allocating and freeing a batch of 16 blocks, re-allocating in place" << std::endl;
+    int* abuf[16] = {nullptr};
+    assert(st.alloc_batch(4 * sizeof(int), 16, abuf) == 16);
+    assert(s.allocs == 20);
+    i = st.realloc(abuf[15], 64 * sizeof(int));
+    assert(i == abuf[15]);
+    prints(st.stats());
+    assert(s.used == 15 * 32 + 272 && s.allocs == 20);
+    st.free_batch(abuf, 16);
+    i = nullptr;
+    prints(st.stats());
+    assert(s.used == 0 && s.free_blocks == 1 && s.frees == 20);
+
+    /* The largest free block stays exact with segregated ordering and the treap, and
+     * an upper bound for the single freelist, which has no size order to read it from */
+    std::cout << std::endl << pr_inf << "checking the largest free block (single list, seg, treap)" << std::endl;
+    check_largest<stalloc_t<16384, int, stalloc_fit_t::first_fit, stalloc_ord_t::addr_order>, false>();
+    check_largest<stalloc_t<16384, int, stalloc_fit_t::first_fit, stalloc_ord_t::lifo_order>, false>();
+    check_largest<stalloc_t<16384, int, stalloc_fit_t::first_fit, stalloc_ord_t::seg_order>>();
+    check_largest<stalloc_t<16384, int, stalloc_fit_t::best_fit, stalloc_ord_t::addr_order>>();
+
+    return 0;
+}
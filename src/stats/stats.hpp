@@ -0,0 +1,34 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * stalloc_stats_t
+ *
+ * Allocator statistics, kept up to date incrementally by stalloc_t
+ * when STALLOC_STATS is defined and read with stalloc_t::stats().
+ * Sizes are block sizes in bytes, including boundary tags.
+ */
+struct stalloc_stats_t {
+    /* Free block size classes: class i holds blocks of [2^(i+5), 2^(i+6)) bytes */
+    static constexpr size_t CLASSES = 32;
+    static constexpr size_t CLASS(size_t size) {
+        return (size < 64) ? 0 : (std::bit_width(size) - 6 < CLASSES) ? std::bit_width(size) - 6 : CLASSES - 1;
+    }
+
+    size_t used = 0;                /* Bytes in allocated blocks */
+    size_t peak = 0;                /* Highest value of used */
+    size_t free_bytes = 0;          /* Bytes in free blocks */
+    size_t free_blocks = 0;         /* Number of free blocks */
+    size_t largest = 0;             /* Size of the largest free block */
+    size_t classes[CLASSES] = {0};  /* Number of free blocks per size class */
+
+    uint64_t allocs = 0;            /* Successful allocations */
+    uint64_t frees = 0;             /* Successful de-allocations */
+    uint64_t fails = 0;             /* Failed allocations */
+
+    /* External fragmentation: share of free bytes outside the largest free block */
+    double frag() const { return free_bytes ? 1. - (double)largest / (double)free_bytes : 0.; }
+};
@@ -0,0 +1,144 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../explist/stalloc.hpp"
+#include "sync.hpp"
+
+#define pr_inf "inf[" << __func__ << "]: "
+#define pr_err "err[" << __func__ << "]: "
+
+/* Baseline: every alloc/free serialized by a std::mutex */
+template<typename A, typename T>
+struct mutex_sync_t {
+    A arena;
+    std::mutex mtx;
+
+    T* alloc(const size_t size) { std::lock_guard<std::mutex> lg(mtx); return arena.alloc(size); }
+    void free(T* const bp) { std::lock_guard<std::mutex> lg(mtx); arena.free(bp); }
+    void flush() {}
+};
+
+/* Run nthreads workers, each keeping up to 32 live blocks of 1B-128B filled with a
+ * per-thread pattern that is verified on free. Returns the elapsed time in seconds */
+template<typename S>
+double stress_test(S& st, const int nthreads, const int ops) {
+    auto worker = [&st, ops](const int id) {
+        unsigned char* live[32] = {nullptr};
+        size_t sizes[32] = {0};
+        uint32_t rng = 0x9e3779b9u * (id + 1);
+
+        for (int n = 0; n < ops; n++) {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+
+            const int slot = rng % 32;
+            if (live[slot]) {
+                for (size_t x = 0; x < sizes[slot]; x++)
+                    assert(live[slot][x] == (unsigned char)(id + slot));
+                st.free(live[slot]);
+                live[slot] = nullptr;
+            } else {
+                sizes[slot] = 1 + (rng >> 8) % 128;
+                if ((live[slot] = st.alloc(sizes[slot]))) {
+                    for (size_t x = 0; x < sizes[slot]; x++)
+                        live[slot][x] = (unsigned char)(id + slot);
+                }
+            }
+        }
+        for (int slot = 0; slot < 32; slot++)
+            st.free(live[slot]);
+        st.flush();
+    };
+
+    std::vector<std::thread> threads;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int id = 0; id < nthreads; id++)
+        threads.emplace_back(worker, id);
+    for (std::thread& t : threads)
+        t.join();
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double>(end_time - start_time).count();
+}
+
+int main() {
+    stalloc_sync_t<stalloc_t<4096>, int, stalloc_con_t::thread_cache> st;
+
+    int* i = nullptr;
+    int* j = nullptr;
+
+    /* Freed small blocks are cached and handed back to the same thread */
+    std::cout << std::endl << pr_inf << "allocating, freeing and re-allocating a 16B block (thread cache)" << std::endl;
+    i = st.alloc(4 * sizeof(int));
+    assert(i);
+    st.free(i);
+    j = st.alloc(3 * sizeof(int));
+    assert(j == i);
+    st.arena().printb();
+
+    /* Cached blocks stay allocated in the wrapped allocator until flushed */
+    std::cout << std::endl << pr_inf << "freeing j (" << j << ") and flushing the thread cache" << std::endl;
+    st.free(j);
+    st.flush();
+    i = j = nullptr;
+    st.arena().printb();
+
+    /* A failing allocation flushes the thread cache and retries */
+    std::cout << std::endl << pr_inf << "caching a 16B block, then allocating block of max size" << std::endl;
+    i = st.alloc(4 * sizeof(int));
+    st.free(i);
+    i = st.alloc(1016 * sizeof(int));
+    assert(i);
+    st.free(i);
+    i = nullptr;
+
+    /* Blocks cached by a thread that exits without flushing are drained on exit */
+    std::cout << std::endl << pr_inf << "caching 16B blocks in threads that exit without flushing" << std::endl;
+    for (int n = 0; n < 16; n++) {
+        std::thread([&st]() {
+            int* bufs[8];
+            for (int idx = 0; idx < 8; idx++) {
+                bufs[idx] = st.alloc(4 * sizeof(int));
+                assert(bufs[idx]);
+            }
+            for (int idx = 0; idx < 8; idx++)
+                st.free(bufs[idx]);
+        }).join();
+    }
+    st.arena().printb();
+    i = st.alloc(1016 * sizeof(int));
+    assert(i);
+    st.free(i);
+    i = nullptr;
+
+    /* Multi-threaded stress test. All blocks must coalesce back into one once every thread is done */
+    constexpr int nthreads = 4;
+    constexpr int ops = 1 << 20;
+
+    std::cout << std::endl << pr_inf << "running multi-threaded stress test ("
+              << nthreads << " threads, " << ops << " ops each)..." << std::endl;
+
+    mutex_sync_t<stalloc_t<65536, unsigned char>, unsigned char> mst;
+    stalloc_sync_t<stalloc_t<65536>, unsigned char, stalloc_con_t::spin_lock> sst;
+    stalloc_sync_t<stalloc_t<65536>, unsigned char, stalloc_con_t::thread_cache> cst;
+
+    const double mdur = stress_test(mst, nthreads, ops);
+    std::cout << pr_inf << "std::mutex done [" << mdur << "s, " << nthreads * ops / mdur / 1e6 << " Mops/s]" << std::endl;
+    const double sdur = stress_test(sst, nthreads, ops);
+    std::cout << pr_inf << "stalloc_con_t::spin_lock done [" << sdur << "s, " << nthreads * ops / sdur / 1e6 << " Mops/s]" << std::endl;
+    const double cdur = stress_test(cst, nthreads, ops);
+    std::cout << pr_inf << "stalloc_con_t::thread_cache done [" << cdur << "s, " << nthreads * ops / cdur / 1e6 << " Mops/s]" << std::endl;
+
+    unsigned char* p = sst.alloc(65536 - 32);
+    assert(p);
+    sst.free(p);
+    p = cst.alloc(65536 - 32);
+    assert(p);
+    cst.free(p);
+
+    return 0;
+}
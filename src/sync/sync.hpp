@@ -0,0 +1,361 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+enum stalloc_con_t { spin_lock, thread_cache };
+
+/**
+ * stalloc_sync_t
+ *
+ * Thread-safe front-end for any stalloc_t (A, instantiated with
+ * T = void). The wrapped allocator is guarded by a spinlock.
+ *
+ * Concurrency policy may be chosen at compile time/instantiation
+ * via the stalloc_con_t type template parameter. Defaults to
+ * stalloc_con_t::spin_lock, which takes the lock on every call.
+ *
+ * With stalloc_con_t::thread_cache, each of up to Threads threads
+ * owns a cache of recently freed small blocks (at most TC_MAX bytes,
+ * one LIFO stack per DSIZE size class). alloc() and free() are then
+ * served from the calling thread's cache without taking the lock.
+ * A full stack is drained to the wrapped allocator in one batch, and
+ * a miss allocates from the wrapped allocator under the lock. The
+ * cache of an exiting thread is drained and released to other
+ * threads.
+ *
+ * Note: thread caches read the size of allocated blocks without the
+ * lock, so the wrapped allocator must not rewrite headers of allocated
+ * blocks (i.e. cannot be combined with stalloc_ftr_t::elide_ftrs).
+ */
+template<typename A, typename T = void, stalloc_con_t C = stalloc_con_t::spin_lock, size_t Threads = 8>
+class stalloc_sync_t {
+    /* Word and double-word sizes, architecture dependant (bytes) */
+    static constexpr size_t WSIZE = sizeof(void*);
+    static constexpr size_t DSIZE = 2 * WSIZE;
+
+    /* Thread cache size classes (class i caches blocks with i + 1 DSIZE usable
+     * bytes) and the depth of each class's stack */
+    static constexpr size_t TC_MAX = 4 * DSIZE;
+    static constexpr size_t TC_COUNT = TC_MAX / DSIZE;
+    static constexpr size_t TC_DEPTH = 16;
+    static constexpr size_t TC_INDEX(size_t size) { return (size - 1) / DSIZE; }
+    static constexpr size_t TC_SIZE(size_t cls) { return (cls + 1) * DSIZE; }
+
+    /* Per-thread cache, cache line aligned to avoid false sharing. Owned
+     * caches are also linked into their thread's list, drained on exit */
+    struct alignas(64) tc_t {
+        std::atomic<std::thread::id> owner;
+        uint32_t count[TC_COUNT] = {0};
+        void* blocks[TC_COUNT][TC_DEPTH];
+        stalloc_sync_t* sync = nullptr;
+        tc_t* t_next = nullptr;
+        tc_t** t_prevp = nullptr;
+    };
+
+    /* Calling thread's owned caches, over all allocators of this type */
+    struct tc_exit_t {
+        tc_t* head = nullptr;
+        ~tc_exit_t();
+    };
+
+    /* Calling thread's last used cache */
+    struct tc_memo_t {
+        const void* sync;
+        tc_t* tc;
+    };
+
+    /* Placeholder for caches when caching is disabled */
+    struct tc_none_t {};
+
+    /* Pointer type handed out by the wrapped allocator */
+    using AT = decltype(std::declval<A&>().alloc(0));
+
+    /* Ensure T is a trivially copyable type (or void) */
+    static_assert(std::is_trivially_copyable_v<T> || std::is_void_v<T>);
+
+    static constexpr bool CACHE = (C == stalloc_con_t::thread_cache);
+
+    /* Ensure headers read by thread caches are not rewritten under the lock */
+    static_assert(!CACHE || !requires { requires A::ELIDE_FTRS; });
+
+    /* Ensure usable sizes are DSIZE multiples, as thread cache classes assume
+     * (compact tags only align blocks to 8 or 4 bytes) */
+    static_assert(!CACHE || !requires { requires A::ALIGNMENT < DSIZE; });
+
+    private:
+        A m_arena;
+        std::atomic_flag m_lock = ATOMIC_FLAG_INIT;
+        [[no_unique_address]] std::conditional_t<CACHE, tc_t[Threads], tc_none_t> m_caches;
+
+        static inline thread_local tc_memo_t t_memo = {nullptr, nullptr};
+        static inline thread_local tc_exit_t t_exit;
+
+        /* Guards every thread's list of owned caches (and the links of caches) */
+        static inline std::atomic_flag s_tlock = ATOMIC_FLAG_INIT;
+
+        void lock();
+        void unlock() { m_lock.clear(std::memory_order_release); }
+
+        static void tlock() {
+            while (s_tlock.test_and_set(std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+        static void tunlock() { s_tlock.clear(std::memory_order_release); }
+
+        tc_t* tc_get();
+        void tc_drain(tc_t* const tc, const size_t cls, const uint32_t n);
+
+        static void tc_link(tc_t* const tc);
+        static void tc_unlink(tc_t* const tc);
+
+    public:
+        ~stalloc_sync_t();
+
+        [[nodiscard]] T* alloc(const size_t size);
+        void free(T* const bp);
+
+        /* Return the calling thread's cached blocks to the wrapped allocator */
+        void flush();
+
+        /* Wrapped allocator. Not synchronized (e.g. for printb() when idle) */
+        A& arena() { return m_arena; }
+};
+
+/**
+ * stalloc_sync_t::lock()
+ *
+ * Acquire the spinlock guarding the wrapped allocator. Spins on
+ * a plain load so that waiting threads do not bounce the cache
+ * line between cores.
+ */
+template<typename A, typename T, stalloc_con_t C, size_t Threads>
+void stalloc_sync_t<A, T, C, Threads>::lock() {
+    while (m_lock.test_and_set(std::memory_order_acquire)) {
+        while (m_lock.test(std::memory_order_relaxed))
+            std::this_thread::yield();
+    }
+}
+
+/**
+ * stalloc_sync_t::tc_link()
+ *
+ * Link a newly claimed cache into the calling thread's list of
+ * owned caches.
+ */
+template<typename A, typename T, stalloc_con_t C, size_t Threads>
+void stalloc_sync_t<A, T, C, Threads>::tc_link(tc_t* const tc) {
+    tlock();
+    tc->t_next = t_exit.head;
+    tc->t_prevp = &t_exit.head;
+    if (t_exit.head)
+        t_exit.head->t_prevp = &tc->t_next;
+    t_exit.head = tc;
+    tunlock();
+}
+
+/**
+ * stalloc_sync_t::tc_unlink()
+ *
+ * Unlink a cache from its owning thread's list. Called with the
+ * list lock held.
+ */
+template<typename A, typename T, stalloc_con_t C, size_t Threads>
+void stalloc_sync_t<A, T, C, Threads>::tc_unlink(tc_t* const tc) {
+    *tc->t_prevp = tc->t_next;
+    if (tc->t_next)
+        tc->t_next->t_prevp = tc->t_prevp;
+    tc->t_next = nullptr;
+    tc->t_prevp = nullptr;
+}
+
+/**
+ * stalloc_sync_t::tc_exit_t::~tc_exit_t()
+ *
+ * Thread exit. Every cache owned by the exiting thread is drained
+ * to its wrapped allocator and released, so that its blocks and the
+ * cache itself can be reused by other threads. Allocators destroyed
+ * first have already unlinked their caches.
+ */
+template<typename A, typename T, stalloc_con_t C, size_t Threads>
+stalloc_sync_t<A, T, C, Threads>::tc_exit_t::~tc_exit_t() {
+    tlock();
+    while (head) {
+        tc_t* const tc = head;
+        tc_unlink(tc);
+        for (size_t cls = 0; cls < TC_COUNT; cls++)
+            tc->sync->tc_drain(tc, cls, tc->count[cls]);
+        tc->owner.store(std::thread::id(), std::memory_order_release);
+    }
+    tunlock();
+}
+
+/**
+ * stalloc_sync_t::~stalloc_sync_t()
+ *
+ * Unlink the caches still owned by threads, which must no longer
+ * use the allocator, so that their exit does not touch it.
+ */
+template<typename A, typename T, stalloc_con_t C, size_t Threads>
+stalloc_sync_t<A, T, C, Threads>::~stalloc_sync_t() {
+    if constexpr (CACHE) {
+        tlock();
+        for (tc_t& tc : m_caches) {
+            if (tc.t_prevp)
+                tc_unlink(&tc);
+        }
+        tunlock();
+    }
+}
+
+/**
+ * stalloc_sync_t::tc_get()
+ *
+ * Get the calling thread's cache, claiming a free one on first
+ * use. Returns nullptr if all caches are owned by other threads,
+ * in which case the calling thread always takes the lock.
+ */
+template<typename A, typename T, stalloc_con_t C, size_t Threads>
+typename stalloc_sync_t<A, T, C, Threads>::tc_t*
+stalloc_sync_t<A, T, C, Threads>::tc_get() {
+    const std::thread::id self = std::this_thread::get_id();
+
+    /* Fast path, same allocator as last call (owner rechecked in case
+     * another allocator has since been constructed at the same address) */
+    if (t_memo.sync == this && t_memo.tc->owner.load(std::memory_order_relaxed) == self)
+        return t_memo.tc;
+
+    for (tc_t& tc : m_caches) {
+        std::thread::id owner = tc.owner.load(std::memory_order_relaxed);
+        if (owner == self) {
+            t_memo = {this, &tc};
+            return &tc;
+        }
+        if (owner == std::thread::id() && tc.owner.compare_exchange_strong(owner, self)) {
+            tc.sync = this;
+            tc_link(&tc);
+            t_memo = {this, &tc};
+            return &tc;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * stalloc_sync_t::tc_drain()
+ *
+ * Return the n oldest blocks of a cache's size class to the
+ * wrapped allocator under a single lock.
+ */
+template<typename A, typename T, stalloc_con_t C, size_t Threads>
+void stalloc_sync_t<A, T, C, Threads>::tc_drain(tc_t* const tc, const size_t cls, const uint32_t n) {
+    void** const blocks = tc->blocks[cls];
+
+    lock();
+    for (uint32_t i = 0; i < n; i++)
+        m_arena.free(static_cast<AT>(blocks[i]));
+    unlock();
+
+    for (uint32_t i = n; i < tc->count[cls]; i++)
+        blocks[i - n] = blocks[i];
+    tc->count[cls] -= n;
+}
+
+/**
+ * stalloc_sync_t::flush()
+ *
+ * Return all blocks cached by the calling thread to the wrapped
+ * allocator. Done automatically when the thread exits.
+ */
+template<typename A, typename T, stalloc_con_t C, size_t Threads>
+void stalloc_sync_t<A, T, C, Threads>::flush() {
+    if constexpr (CACHE) {
+        tc_t* const tc = tc_get();
+        if (!tc)
+            return;
+
+        for (size_t cls = 0; cls < TC_COUNT; cls++)
+            tc_drain(tc, cls, tc->count[cls]);
+    }
+}
+
+/**
+ * stalloc_sync_t::alloc()
+ *
+ * Public facing allocation subroutine. With thread caches, small
+ * requests are first served from the calling thread's cache. Cache
+ * misses are allocated at the size class size so that the block can
+ * be cached again when freed. If the wrapped allocator is out of
+ * space the calling thread's cache is flushed and the allocation
+ * retried once. Returns nullptr on failure.
+ */
+template<typename A, typename T, stalloc_con_t C, size_t Threads>
+T* stalloc_sync_t<A, T, C, Threads>::alloc(const size_t size) {
+    /* Ignore zero-sized requests */
+    if (!size)
+        return nullptr;
+
+    size_t asize = size;
+
+    if constexpr (CACHE) {
+        tc_t* const tc = (size <= TC_MAX) ? tc_get() : nullptr;
+        if (tc) {
+            const size_t cls = TC_INDEX(size);
+            if (tc->count[cls])
+                return static_cast<T*>(tc->blocks[cls][--tc->count[cls]]);
+            asize = TC_SIZE(cls);
+        }
+    }
+
+    lock();
+    void* bp = static_cast<void*>(m_arena.alloc(asize));
+    unlock();
+
+    if constexpr (CACHE) {
+        if (!bp) {
+            flush();
+            lock();
+            bp = static_cast<void*>(m_arena.alloc(asize));
+            unlock();
+        }
+    }
+
+    return static_cast<T*>(bp);
+}
+
+/**
+ * stalloc_sync_t::free()
+ *
+ * Public facing de-allocation subroutine. With thread caches, small
+ * blocks are pushed onto the calling thread's cache, draining half
+ * of a full size class first. Silently fails if given an invalid
+ * request.
+ */
+template<typename A, typename T, stalloc_con_t C, size_t Threads>
+void stalloc_sync_t<A, T, C, Threads>::free(T* const bp) {
+    void* const vbp = static_cast<void*>(bp);
+
+    /* Ignore invalid requests */
+    if (!vbp)
+        return;
+
+    if constexpr (CACHE) {
+        const size_t usize = m_arena.usable_size(static_cast<AT>(vbp));
+        tc_t* const tc = (usize >= DSIZE && usize <= TC_MAX) ? tc_get() : nullptr;
+        if (tc) {
+            const size_t cls = usize / DSIZE - 1;
+            if (tc->count[cls] == TC_DEPTH)
+                tc_drain(tc, cls, TC_DEPTH / 2);
+            tc->blocks[cls][tc->count[cls]++] = vbp;
+            return;
+        }
+    }
+
+    lock();
+    m_arena.free(static_cast<AT>(vbp));
+    unlock();
+}
@@ -0,0 +1,922 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+#ifdef STALLOC_TRACE
+#include "../trace/trace.hpp"
+#endif
+
+#ifdef STALLOC_STATS
+#include "../stats/stats.hpp"
+#endif
+
+template<size_t MaxSize, typename T = void>
+class stalloc_t {
+    /* Word and double-word sizes, architecture dependant (bytes) */
+    /* Note: On 64-bit architectures, alignment (DSIZE) is 16 bytes */
+    static constexpr size_t WSIZE = sizeof(void*);
+    static constexpr size_t DSIZE = 2 * WSIZE;
+
+    /* Pack size and alloc bit into a word for header/footer */
+    /* Note: size is assumed to be DSIZE aligned */
+    static constexpr uintptr_t PACK(size_t size, bool alloc) { return (size | alloc); }
+
+    /* Read and write a word at address p */
+    static constexpr uintptr_t GET(void* p) { return *(uintptr_t*)p; }
+    static constexpr void PUT(void* p, uintptr_t v) { *(uintptr_t*)p = v; }
+
+    /* Read size and alloc fields from address p */
+    static constexpr size_t GET_SIZE(void* p) { return GET(p) & ~(DSIZE - 1); }
+    static constexpr size_t GET_ALLOC(void* p) { return GET(p) & 0x1; }
+
+    /* Get header/footer address from block pointer */
+    static constexpr void* HDRP(void* bp) { return (void*)((size_t)bp - WSIZE); }
+    static constexpr void* FTRP(void* bp) { return (void*)((size_t)bp + GET_SIZE(HDRP(bp)) - DSIZE); }
+
+    /* Get next/previous blocks from block pointer */
+    static constexpr void* NEXT_BLKP(void* bp) { return (void*)((size_t)bp + GET_SIZE((void*)((size_t)bp - WSIZE))); }
+    static constexpr void* PREV_BLKP(void* bp) { return (void*)((size_t)bp - GET_SIZE((void*)((size_t)bp - DSIZE))); }
+
+    /* Check if next/previous blocks exist (i.e. if current block is at boundary) */
+    static constexpr bool PREV_EXIST(void* bp) { return GET((void*)((size_t)bp - DSIZE)); }
+    static constexpr bool NEXT_EXIST(void* bp) { return GET((void*)((size_t)bp + GET_SIZE(HDRP(bp)) - WSIZE)); }
+
+    /* Alignment helpers */
+    static constexpr size_t ALIGN_MASK(size_t x, size_t m) { return (x + m) & (~m); }
+    static constexpr size_t ALIGN_UP(size_t x) { return ALIGN_MASK(x, DSIZE-1); }
+    static constexpr size_t ALIGN_SIZE(size_t x) { return (x > DSIZE) ? ALIGN_UP(x) + DSIZE : 2 * DSIZE; }
+
+    /* Two-level segregated fit mapping. The first level splits block sizes
+     * by powers of two, the second level splits each power-of-two range
+     * linearly into SL_COUNT lists. Sizes below SMALL_SIZE share first
+     * level 0, whose lists are exactly DSIZE apart */
+    static constexpr size_t SL_LOG2 = 4;
+    static constexpr size_t SL_COUNT = (size_t)1 << SL_LOG2;
+    static constexpr size_t FL_SHIFT = SL_LOG2 + std::countr_zero(DSIZE);
+    static constexpr size_t SMALL_SIZE = (size_t)1 << FL_SHIFT;
+    static constexpr size_t FL_COUNT = (MaxSize < SMALL_SIZE) ? 1 : std::bit_width(MaxSize) - FL_SHIFT + 1;
+
+    /* Get first/second level list indices from block size */
+    static constexpr size_t FL_INDEX(size_t size) { return (size < SMALL_SIZE) ? 0 : std::bit_width(size) - FL_SHIFT; }
+    static constexpr size_t SL_INDEX(size_t size) { return (size < SMALL_SIZE) ? size / DSIZE : (size >> (std::bit_width(size) - 1 - SL_LOG2)) - SL_COUNT; }
+
+    /* Round size up to the next list boundary so that any block in its list fits */
+    static constexpr size_t ROUND_SIZE(size_t size) { return (size < SMALL_SIZE) ? size : size + ((size_t)1 << (std::bit_width(size) - 1 - SL_LOG2)) - 1; }
+
+    /* Ensure T is a trivially copyable type (or void) */
+    static_assert(std::is_trivially_copyable_v<T> || std::is_void_v<T>);
+
+    /* Ensure MaxSize is double-word aligned and can fit at least one block */
+    static_assert(((MaxSize & (DSIZE-1)) == 0) && (MaxSize >= 3 * DSIZE));
+
+    /* Freelist type for segregated free linked lists */
+    struct fl_t {
+        fl_t* prev;
+        fl_t* next;
+    };
+
+    private:
+        alignas(DSIZE) unsigned char m_data[MaxSize] = {0};
+        void* const m_listp = m_data + DSIZE;
+        std::atomic<void*> m_rfreep = nullptr;
+        fl_t* m_flists[FL_COUNT][SL_COUNT] = {{nullptr}};
+        uint64_t m_flmap = 0;
+        uint32_t m_slmap[FL_COUNT] = {0};
+
+#ifdef STALLOC_TRACE
+        stalloc_trace_t* m_trace = nullptr;
+
+        void trace_rec(const stalloc_op_t op, void* const bp, const size_t size) {
+            if (m_trace)
+                m_trace->record(op, bp ? (uint32_t)((size_t)bp - (size_t)m_data) : stalloc_trace_t::NO_HANDLE,
+                                (uint32_t)size);
+        }
+#endif
+
+#ifdef STALLOC_STATS
+        stalloc_stats_t m_stats;
+        bool m_stale = false;
+#endif
+
+        /* Statistics bookkeeping, compiled out unless STALLOC_STATS is defined.
+         * Free blocks are counted as they are created (st_add) and destroyed
+         * (st_sub). The largest free block is only an upper bound (stale) once
+         * a block of its size has been destroyed, until stats() reads it back
+         * from the freelists */
+        void st_add([[maybe_unused]] const size_t size) {
+#ifdef STALLOC_STATS
+            m_stats.free_bytes += size;
+            m_stats.free_blocks++;
+            m_stats.classes[stalloc_stats_t::CLASS(size)]++;
+            m_stats.largest = (size > m_stats.largest) ? size : m_stats.largest;
+#endif
+        }
+        void st_sub([[maybe_unused]] const size_t size) {
+#ifdef STALLOC_STATS
+            m_stats.free_bytes -= size;
+            m_stats.free_blocks--;
+            m_stats.classes[stalloc_stats_t::CLASS(size)]--;
+            m_stale |= (size == m_stats.largest);
+#endif
+        }
+        void st_peak() {
+#ifdef STALLOC_STATS
+            m_stats.used = MaxSize - DSIZE - m_stats.free_bytes;
+            m_stats.peak = (m_stats.used > m_stats.peak) ? m_stats.used : m_stats.peak;
+#endif
+        }
+        void st_alloc([[maybe_unused]] const void* const bp, [[maybe_unused]] const size_t n = 1) {
+#ifdef STALLOC_STATS
+            if (bp) {
+                m_stats.allocs += n;
+                st_peak();
+            } else {
+                m_stats.fails++;
+            }
+#endif
+        }
+        void st_free() {
+#ifdef STALLOC_STATS
+            m_stats.frees++;
+#endif
+        }
+
+#ifdef STALLOC_PROBES
+        size_t m_probes = 0;
+#endif
+
+        /* Freelist and bitmap access counting, compiled out unless STALLOC_PROBES
+         * is defined. Every read of a bitmap word or list head and every list
+         * link updated counts as one probe */
+        void st_probe([[maybe_unused]] const size_t n = 1) {
+#ifdef STALLOC_PROBES
+            m_probes += n;
+#endif
+        }
+
+        void* find_fit(const size_t asize);
+        void place(void* const bp, size_t asize);
+        void* coalesce(void* const bp);
+        void split(void* const bp, const size_t asize);
+        void release(void* const bp);
+
+        void fl_insert(void* const bp);
+        void fl_remove(void* const bp);
+
+    public:
+        stalloc_t() {
+            /* First and last words are reserved */
+            PUT(m_data + WSIZE, PACK(MaxSize - DSIZE, false));
+            PUT(FTRP(m_data + DSIZE), PACK(MaxSize - DSIZE, false));
+
+            /* Freelists start with a single node */
+            fl_insert(m_listp);
+
+            st_add(MaxSize - DSIZE);
+        };
+
+        [[nodiscard]] T* alloc(const size_t size);
+        [[nodiscard]] T* alloc_aligned(const size_t size, const size_t align);
+        void free(T* const bp);
+        [[nodiscard]] T* realloc(T* const bp, const size_t size);
+        [[nodiscard]] size_t usable_size(T* const bp);
+        [[nodiscard]] bool can_alloc(const size_t size);
+
+        /* Batched allocation/de-allocation of many blocks at once */
+        [[nodiscard]] size_t alloc_batch(const size_t size, const size_t n, T** const out);
+        void free_batch(T** const ptrs, const size_t n);
+
+        /* Cross-thread de-allocation */
+        void free_remote(T* const bp);
+        void drain();
+
+#ifdef STALLOC_STATS
+        /* Allocator statistics (see stalloc_stats_t) */
+        const stalloc_stats_t& stats();
+#endif
+
+#ifdef STALLOC_PROBES
+        /* Freelist and bitmap probes so far (see st_probe()) */
+        size_t probes() const { return m_probes; }
+#endif
+
+#ifdef STALLOC_TRACE
+        /* Attach (or detach, given nullptr) an allocation trace recorder */
+        void trace(stalloc_trace_t* const tr) {
+            m_trace = tr;
+            if (tr)
+                tr->attach(MaxSize);
+        }
+#endif
+
+        /* Debug */
+        void printb();
+};
+
+/**
+ * stalloc_t::printb()
+ *
+ * Print a formatted representation of the instantiated stack
+ * allocator's block list.
+ */
+template<size_t MaxSize, typename T>
+void stalloc_t<MaxSize, T>::printb() {
+    printf("+------------------------------------------------+\n"
+           "|                      Stack                     |\n"
+           "+-------+----------------+--------------+--------+\n"
+           "| Block |     Address    |     Size     | Status |\n"
+           "+-------+----------------+--------------+--------+\n");
+
+    int i = 0;
+    for (void* bp = m_listp; GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp), i++) {
+        printf("| %-6d| %p | %-13ld|   %c    |\n"
+               "+-------+----------------+--------------+--------+\n",
+                i, bp, GET_SIZE(HDRP(bp)), (GET_ALLOC(HDRP(bp)) ? 'A' : 'F'));
+    }
+}
+
+/**
+ * stalloc_t::fl_insert()
+ *
+ * Insert block at the head of the freelist matching its size
+ * and mark that list as non-empty in both level bitmaps.
+ */
+template<size_t MaxSize, typename T>
+void stalloc_t<MaxSize, T>::fl_insert(void* const bp) {
+    fl_t* const fbp = static_cast<fl_t*>(bp);
+
+    /* Ignore invalid requests */
+    if (!fbp)
+        return;
+
+    const size_t size = GET_SIZE(HDRP(bp));
+    const size_t fl = FL_INDEX(size);
+    const size_t sl = SL_INDEX(size);
+    fl_t*& flistp = m_flists[fl][sl];
+
+    fbp->prev = nullptr;
+    fbp->next = flistp;
+    if (flistp)
+        flistp->prev = fbp;
+    flistp = fbp;
+    st_probe(flistp->next ? 2 : 1);
+
+    m_flmap |= (uint64_t)1 << fl;
+    m_slmap[fl] |= (uint32_t)1 << sl;
+    st_probe(2);
+}
+
+/**
+ * stalloc_t::fl_remove()
+ *
+ * Remove block from its freelist, clearing the bitmap bits of
+ * lists left empty. The block's header must still hold the size
+ * it was inserted with.
+ */
+template<size_t MaxSize, typename T>
+void stalloc_t<MaxSize, T>::fl_remove(void* const bp) {
+    fl_t* const fbp = static_cast<fl_t*>(bp);
+
+    /* Ignore invalid requests */
+    if (!fbp)
+        return;
+
+    const size_t size = GET_SIZE(HDRP(bp));
+    const size_t fl = FL_INDEX(size);
+    const size_t sl = SL_INDEX(size);
+    fl_t*& flistp = m_flists[fl][sl];
+
+    if (fbp->prev)
+        fbp->prev->next = fbp->next;
+    else
+        flistp = fbp->next;
+    if (fbp->next)
+        fbp->next->prev = fbp->prev;
+    st_probe(fbp->next ? 2 : 1);
+
+    fbp->prev = nullptr;
+    fbp->next = nullptr;
+
+    /* List emptied, clear its bit (and first level bit if last list) */
+    if (!flistp) {
+        m_slmap[fl] &= ~((uint32_t)1 << sl);
+        st_probe();
+        if (!m_slmap[fl]) {
+            m_flmap &= ~((uint64_t)1 << fl);
+            st_probe();
+        }
+    }
+}
+
+/**
+ * stalloc_t::find_fit()
+ *
+ * Free block fit finder. Returns pointer to the allotted
+ * block if fit is found. Otherwise returns nullptr.
+ *
+ * The request is rounded up to the next list boundary so that
+ * the head of any non-empty list at or above it is a fit. The
+ * first such list is found with one bit scan per level. If none
+ * exists, the head of the request's own (unrounded) list is
+ * checked as a last resort, so the search is always bounded by
+ * a constant number of steps.
+ */
+template<size_t MaxSize, typename T>
+void* stalloc_t<MaxSize, T>::find_fit(const size_t asize) {
+    const size_t rsize = ROUND_SIZE(asize);
+    size_t fl = FL_INDEX(rsize);
+    const size_t sl = SL_INDEX(rsize);
+
+    if (fl < FL_COUNT) {
+        uint32_t slmap = m_slmap[fl] & (~(uint32_t)0 << sl);
+        st_probe();
+
+        /* No list in this range, move to next non-empty range */
+        if (!slmap) {
+            const uint64_t flmap = m_flmap & (~(uint64_t)0 << (fl + 1));
+            st_probe();
+            if (flmap) {
+                fl = std::countr_zero(flmap);
+                slmap = m_slmap[fl];
+                st_probe();
+            }
+        }
+        if (slmap) {
+            st_probe();
+            return static_cast<void*>(m_flists[fl][std::countr_zero(slmap)]);
+        }
+    }
+
+    fl_t* const flp = m_flists[FL_INDEX(asize)][SL_INDEX(asize)];
+    st_probe();
+    return (flp && asize <= GET_SIZE(HDRP(flp))) ? static_cast<void*>(flp) : nullptr;
+}
+
+/**
+ * stalloc_t::place()
+ *
+ * Sets the header and footer of the allotted block and leftover
+ * block (when applicable) to (total_size | 1) to complete allocation.
+ * The size placed in the header/footer includes that of the header and
+ * footer themselves.
+ */
+template<size_t MaxSize, typename T>
+void stalloc_t<MaxSize, T>::place(void* const bp, size_t asize) {
+    /* Get current (free) block size and leftover block size */
+    const size_t fsize = GET_SIZE(HDRP(bp));
+    const size_t lsize = fsize - asize;
+
+    fl_remove(bp);
+
+    st_sub(fsize);
+
+    /* If leftover size is too small for another block, use all of free
+     * block size. Otherwise set leftover block size accordingly */
+    if (lsize < 2 * DSIZE) {
+        asize = fsize;
+    } else {
+        PUT(HDRP((void*)((size_t)bp + asize)), PACK(lsize, false));
+        PUT(FTRP((void*)((size_t)bp + asize)), PACK(lsize, false));
+        st_add(lsize);
+        fl_insert((void*)((size_t)bp + asize));
+    }
+
+    /* Write header and footer for newly allocated block */
+    PUT(HDRP(bp), PACK(asize, true));
+    PUT(FTRP(bp), PACK(asize, true));
+}
+
+/**
+ * stalloc_t::alloc()
+ *
+ * Public facing allocation subroutine. Attempts to find a free
+ * block of adequate size for the request. Returns a pointer to
+ * the start of that free block on success. Returns nullptr on
+ * failure.
+ *
+ * The block header is one word prior to the start of the newly
+ * allotted block whose address is returned to the user. Similarly,
+ * the block footer is located directly after the end of the aligned
+ * block.
+ *
+ * The start address of the newly allotted block is always double-
+ * word aligned, as is the size of the block.
+ */
+template<size_t MaxSize, typename T>
+T* stalloc_t<MaxSize, T>::alloc(const size_t size) {
+    /* Ignore zero-sized and known-too-large requests */
+    if (!size || size > MaxSize - (2 * DSIZE))
+        return nullptr;
+
+    /* Reclaim blocks freed by other threads */
+    drain();
+
+    void* bp = nullptr;
+    const size_t asize = ALIGN_SIZE(size);
+
+    if ((bp = find_fit(asize)))
+        place(bp, asize);
+
+    st_alloc(bp);
+
+#ifdef STALLOC_TRACE
+    trace_rec(alloc_op, bp, size);
+#endif
+
+    return static_cast<T*>(bp);
+}
+
+/**
+ * stalloc_t::alloc_aligned()
+ *
+ * Aligned allocation subroutine, see the implicit list's
+ * stalloc_t::alloc_aligned(). The slack search is a single good-fit
+ * lookup, skipped when the slack would reach past the arena (the
+ * lists do not cover such sizes).
+ */
+template<size_t MaxSize, typename T>
+T* stalloc_t<MaxSize, T>::alloc_aligned(const size_t size, const size_t align) {
+    /* Ignore invalid alignments, zero-sized and known-too-large requests */
+    if (!align || (align & (align - 1)) || !size || size > MaxSize - (2 * DSIZE) || align > MaxSize)
+        return nullptr;
+
+    /* Every block is DSIZE aligned */
+    if (align <= DSIZE)
+        return alloc(size);
+
+    /* Reclaim blocks freed by other threads */
+    drain();
+
+    /* Fits with slack beyond the arena would index past the lists */
+    const size_t asize = ALIGN_SIZE(size);
+    void* bp = (asize + align + DSIZE <= MaxSize - DSIZE) ? find_fit(asize + align + DSIZE) : nullptr;
+
+    /* Split off the free space before the aligned address */
+    size_t gap = bp ? (align - ((size_t)bp & (align - 1))) & (align - 1) : 0;
+    if (gap == DSIZE)
+        gap += align;
+    if (gap) {
+        const size_t fsize = GET_SIZE(HDRP(bp));
+        void* const abp = (void*)((size_t)bp + gap);
+
+        fl_remove(bp);
+        st_sub(fsize);
+        PUT(HDRP(bp), PACK(gap, false));
+        PUT(FTRP(bp), PACK(gap, false));
+        PUT(HDRP(abp), PACK(fsize - gap, false));
+        PUT(FTRP(abp), PACK(fsize - gap, false));
+        st_add(gap);
+        st_add(fsize - gap);
+        fl_insert(bp);
+        fl_insert(abp);
+
+        bp = abp;
+    }
+
+    if (bp)
+        place(bp, asize);
+
+    st_alloc(bp);
+
+#ifdef STALLOC_TRACE
+    trace_rec(alloc_op, bp, size);
+#endif
+
+    return static_cast<T*>(bp);
+}
+
+/**
+ * stalloc_t::free()
+ *
+ * Public facing de-allocation subroutine. Attempts to free the
+ * given block whose pointer is provided by the user. Silently
+ * fails if given an invalid request.
+ *
+ * On success attempts to coalesce adjacent free blocks, then
+ * inserts the resulting block into its freelist.
+ */
+template<size_t MaxSize, typename T>
+void stalloc_t<MaxSize, T>::free(T* const bp) {
+    void* const vbp = static_cast<void*>(bp);
+
+    /* Ignore invalid requests */
+    if (!vbp || !GET_ALLOC(HDRP(vbp)))
+        return;
+
+#ifdef STALLOC_TRACE
+    trace_rec(free_op, vbp, 0);
+#endif
+
+    st_free();
+    release(vbp);
+}
+
+/**
+ * stalloc_t::release()
+ *
+ * Free an allocated block and coalesce it with adjacent free
+ * blocks. Shared by free(), free_batch() and split(), which have
+ * already validated the block.
+ */
+template<size_t MaxSize, typename T>
+void stalloc_t<MaxSize, T>::release(void* const bp) {
+    const size_t size = GET_SIZE(HDRP(bp));
+    PUT(HDRP(bp), PACK(size, false));
+    PUT(FTRP(bp), PACK(size, false));
+    st_add(size);
+
+    fl_insert(coalesce(bp));
+}
+
+/**
+ * stalloc_t::free_remote()
+ *
+ * De-allocation subroutine for threads other than the one owning
+ * the allocator. The block is pushed onto a lock-free queue of
+ * remotely freed blocks, linked through the first word of each
+ * block's payload. The owning thread frees queued blocks in
+ * drain(), which alloc() also calls on entry.
+ */
+template<size_t MaxSize, typename T>
+void stalloc_t<MaxSize, T>::free_remote(T* const bp) {
+    void* const vbp = static_cast<void*>(bp);
+
+    /* Ignore invalid requests */
+    if (!vbp)
+        return;
+
+    void* head = m_rfreep.load(std::memory_order_relaxed);
+    do {
+        *(void**)vbp = head;
+    } while (!m_rfreep.compare_exchange_weak(head, vbp, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+}
+
+/**
+ * stalloc_t::drain()
+ *
+ * Free all blocks queued by free_remote(). Must only be called by
+ * the thread owning the allocator. The whole queue is detached
+ * in one exchange, so this costs a single plain load when the
+ * queue is empty.
+ */
+template<size_t MaxSize, typename T>
+void stalloc_t<MaxSize, T>::drain() {
+    if (!m_rfreep.load(std::memory_order_relaxed))
+        return;
+
+    void* bp = m_rfreep.exchange(nullptr, std::memory_order_acquire);
+    while (bp) {
+        void* const next = *(void**)bp;
+        free(static_cast<T*>(bp));
+        bp = next;
+    }
+}
+
+/**
+ * stalloc_t::split()
+ *
+ * Shrink an allocated block to asize, freeing its tail (and
+ * coalescing it with the following block) when the tail is large
+ * enough to form another block.
+ */
+template<size_t MaxSize, typename T>
+void stalloc_t<MaxSize, T>::split(void* const bp, const size_t asize) {
+    const size_t size = GET_SIZE(HDRP(bp));
+
+    if (size - asize < 2 * DSIZE)
+        return;
+
+    void* const tbp = (void*)((size_t)bp + asize);
+
+    PUT(HDRP(bp), PACK(asize, true));
+    PUT(FTRP(bp), PACK(asize, true));
+
+    PUT(HDRP(tbp), PACK(size - asize, true));
+    PUT(FTRP(tbp), PACK(size - asize, true));
+
+    release(tbp);
+}
+
+/**
+ * stalloc_t::realloc()
+ *
+ * Public facing re-allocation subroutine, see the implicit list's
+ * stalloc_t::realloc(). Absorbed neighbours are unlinked from their
+ * segregated lists in constant time, so resizing in place is O(1).
+ */
+template<size_t MaxSize, typename T>
+T* stalloc_t<MaxSize, T>::realloc(T* const bp, const size_t size) {
+    void* const vbp = static_cast<void*>(bp);
+
+    if (!vbp)
+        return alloc(size);
+
+    if (!size) {
+        free(bp);
+        return nullptr;
+    }
+
+    /* Ignore invalid and known-too-large requests */
+    if (!GET_ALLOC(HDRP(vbp)) || size > MaxSize - (2 * DSIZE))
+        return nullptr;
+
+    const size_t asize = ALIGN_SIZE(size);
+    const size_t csize = GET_SIZE(HDRP(vbp));
+
+    /* Shrink in place */
+    if (asize <= csize) {
+        split(vbp, asize);
+#ifdef STALLOC_TRACE
+        trace_rec(free_op, vbp, 0);
+        trace_rec(alloc_op, vbp, size);
+#endif
+        return bp;
+    }
+
+    void* const nbp = NEXT_BLKP(vbp);
+    const size_t nsize = (NEXT_EXIST(vbp) && !GET_ALLOC(HDRP(nbp))) ? GET_SIZE(HDRP(nbp)) : 0;
+
+    /* Grow in place into the following free block */
+    if (csize + nsize >= asize) {
+        st_sub(nsize);
+        fl_remove(nbp);
+        PUT(HDRP(vbp), PACK(csize + nsize, true));
+        PUT(FTRP(vbp), PACK(csize + nsize, true));
+
+        split(vbp, asize);
+        st_peak();
+#ifdef STALLOC_TRACE
+        trace_rec(free_op, vbp, 0);
+        trace_rec(alloc_op, vbp, size);
+#endif
+        return bp;
+    }
+
+    /* Grow into the preceding (and following) free block, moving contents down */
+    if (PREV_EXIST(vbp) && !GET_ALLOC(HDRP(PREV_BLKP(vbp)))) {
+        void* const pbp = PREV_BLKP(vbp);
+        const size_t tsize = GET_SIZE(HDRP(pbp)) + csize + nsize;
+
+        if (tsize >= asize) {
+            st_sub(GET_SIZE(HDRP(pbp)));
+            if (nsize)
+                st_sub(nsize);
+            fl_remove(pbp);
+            if (nsize)
+                fl_remove(nbp);
+
+            memmove(pbp, vbp, csize - DSIZE);
+            PUT(HDRP(pbp), PACK(tsize, true));
+            PUT(FTRP(pbp), PACK(tsize, true));
+
+            split(pbp, asize);
+            st_peak();
+#ifdef STALLOC_TRACE
+            trace_rec(free_op, vbp, 0);
+            trace_rec(alloc_op, pbp, size);
+#endif
+            return static_cast<T*>(pbp);
+        }
+    }
+
+    /* Fall back to allocate, copy and free */
+    T* const rbp = alloc(size);
+    if (rbp) {
+        memcpy(static_cast<void*>(rbp), vbp, csize - DSIZE);
+        free(bp);
+    }
+    return rbp;
+}
+
+/**
+ * stalloc_t::alloc_batch()
+ *
+ * Public facing batch allocation subroutine, see the implicit list's
+ * stalloc_t::alloc_batch(). The contiguous region is looked up in
+ * constant time as one request of n * size bytes. Being a good fit
+ * (see find_fit()), the lookup may pass over a region that fits
+ * exactly, in which case blocks are allocated one at a time.
+ */
+template<size_t MaxSize, typename T>
+size_t stalloc_t<MaxSize, T>::alloc_batch(const size_t size, const size_t n, T** const out) {
+    /* Ignore zero-sized and known-too-large requests */
+    if (!size || !n || !out || size > MaxSize - (2 * DSIZE))
+        return 0;
+
+    /* Reclaim blocks freed by other threads */
+    drain();
+
+    const size_t asize = ALIGN_SIZE(size);
+    void* bp = nullptr;
+
+    if (n <= MaxSize / asize && (bp = find_fit(n * asize))) {
+        place(bp, n * asize);
+
+        /* Split the placed region, the last block keeps any leftover */
+        const size_t lsize = GET_SIZE(HDRP(bp)) - (n - 1) * asize;
+
+        for (size_t i = 0; i < n; i++) {
+            void* const cbp = (void*)((size_t)bp + i * asize);
+            const size_t csize = (i == n - 1) ? lsize : asize;
+
+            PUT(HDRP(cbp), PACK(csize, true));
+            PUT(FTRP(cbp), PACK(csize, true));
+            out[i] = static_cast<T*>(cbp);
+
+#ifdef STALLOC_TRACE
+            trace_rec(alloc_op, cbp, size);
+#endif
+        }
+
+        st_alloc(bp, n);
+        return n;
+    }
+
+    size_t cnt = 0;
+    while (cnt < n && (out[cnt] = alloc(size)))
+        cnt++;
+    return cnt;
+}
+
+/**
+ * stalloc_t::free_batch()
+ *
+ * Public facing batch de-allocation subroutine, see the implicit
+ * list's stalloc_t::free_batch(). Each merged run is coalesced and
+ * inserted into its segregated list in constant time.
+ */
+template<size_t MaxSize, typename T>
+void stalloc_t<MaxSize, T>::free_batch(T** const ptrs, const size_t n) {
+    if (!ptrs)
+        return;
+
+    std::sort(ptrs, ptrs + n, std::less<T*>());
+
+    void* end = nullptr;
+    for (size_t i = 0; i < n; i++) {
+        void* const vbp = static_cast<void*>(ptrs[i]);
+
+        /* Ignore invalid requests, and blocks already part of a run */
+        if (!vbp || (size_t)vbp < (size_t)end || !GET_ALLOC(HDRP(vbp)))
+            continue;
+
+#ifdef STALLOC_TRACE
+        trace_rec(free_op, vbp, 0);
+#endif
+        st_free();
+
+        /* Extend the run while the next pointer is the next allocated block */
+        end = NEXT_BLKP(vbp);
+        for (; i + 1 < n && static_cast<void*>(ptrs[i + 1]) == end && GET_ALLOC(HDRP(end)); i++) {
+#ifdef STALLOC_TRACE
+            trace_rec(free_op, end, 0);
+#endif
+            st_free();
+            end = NEXT_BLKP(end);
+        }
+
+        const size_t size = (size_t)end - (size_t)vbp;
+        PUT(HDRP(vbp), PACK(size, true));
+        PUT(FTRP(vbp), PACK(size, true));
+
+        release(vbp);
+    }
+}
+
+#ifdef STALLOC_STATS
+/**
+ * stalloc_t::stats()
+ *
+ * See the implicit list's stalloc_t::stats(). The largest free block
+ * is read back from the highest non-empty list (found from the
+ * bitmaps), the only one that can hold it.
+ */
+template<size_t MaxSize, typename T>
+const stalloc_stats_t& stalloc_t<MaxSize, T>::stats() {
+    if (m_stale) {
+        m_stats.largest = 0;
+        if (m_flmap) {
+            const size_t fl = std::bit_width(m_flmap) - 1;
+            for (fl_t* flp = m_flists[fl][std::bit_width(m_slmap[fl]) - 1]; flp; flp = flp->next)
+                m_stats.largest = (GET_SIZE(HDRP(flp)) > m_stats.largest) ? GET_SIZE(HDRP(flp)) : m_stats.largest;
+        }
+        m_stale = false;
+    }
+
+    m_stats.used = MaxSize - DSIZE - m_stats.free_bytes;
+    return m_stats;
+}
+#endif
+
+/**
+ * stalloc_t::can_alloc()
+ *
+ * See the implicit list's stalloc_t::can_alloc(). Every request is
+ * answered in constant time by the same good-fit lookup as alloc()
+ * (see find_fit()).
+ */
+template<size_t MaxSize, typename T>
+bool stalloc_t<MaxSize, T>::can_alloc(const size_t size) {
+    /* Ignore zero-sized and known-too-large requests */
+    if (!size || size > MaxSize - (2 * DSIZE))
+        return false;
+
+    drain();
+    return find_fit(ALIGN_SIZE(size)) != nullptr;
+}
+
+/**
+ * stalloc_t::usable_size()
+ *
+ * See the implicit list's stalloc_t::usable_size(). Blocks always
+ * carry a footer, so the block size less DSIZE is usable.
+ */
+template<size_t MaxSize, typename T>
+size_t stalloc_t<MaxSize, T>::usable_size(T* const bp) {
+    void* const vbp = static_cast<void*>(bp);
+
+    /* Ignore invalid requests */
+    if (!vbp || !GET_ALLOC(HDRP(vbp)))
+        return 0;
+
+    return GET_SIZE(HDRP(vbp)) - DSIZE;
+}
+
+/**
+ * stalloc_t::coalesce()
+ *
+ * Attempt to coalesce adjacent free blocks. In order to coalesce,
+ * adjacent block must both exist (i.e. given block pointer is not
+ * at a boundary) and have its alloc flag set to false.
+ *
+ * Merged neighbours are removed from their freelists. Returns
+ * the pointer of the resulting (not yet inserted) free block.
+ */
+template<size_t MaxSize, typename T>
+void* stalloc_t<MaxSize, T>::coalesce(void* const bp) {
+    const bool prev = PREV_EXIST(bp) && !GET_ALLOC(HDRP(PREV_BLKP(bp)));
+    const bool next = NEXT_EXIST(bp) && !GET_ALLOC(HDRP(NEXT_BLKP(bp)));
+
+    void* prev_hdrp = nullptr;
+    void* prev_ftrp = nullptr;
+    void* next_hdrp = nullptr;
+    void* next_ftrp = nullptr;
+    size_t size = GET_SIZE(HDRP(bp));
+
+    if (prev) {
+        fl_remove(PREV_BLKP(bp));
+        prev_hdrp = HDRP(PREV_BLKP(bp));
+        prev_ftrp = FTRP(PREV_BLKP(bp));
+        size += GET_SIZE(prev_hdrp);
+    }
+    if (next) {
+        fl_remove(NEXT_BLKP(bp));
+        next_hdrp = HDRP(NEXT_BLKP(bp));
+        next_ftrp = FTRP(NEXT_BLKP(bp));
+        size += GET_SIZE(next_hdrp);
+    }
+
+    /* Merged blocks are replaced by a single free block */
+    if (prev)
+        st_sub(GET_SIZE(prev_hdrp));
+    if (next)
+        st_sub(GET_SIZE(next_hdrp));
+    if (prev || next) {
+        st_sub(GET_SIZE(HDRP(bp)));
+        st_add(size);
+    }
+
+    if (prev && next) {
+        PUT(prev_ftrp, 0);
+        PUT(prev_hdrp, PACK(size, false));
+
+        PUT(next_ftrp, PACK(size, false));
+        PUT(next_hdrp, 0);
+
+        PUT(FTRP(bp), 0);
+        PUT(HDRP(bp), 0);
+    } else if (prev) {
+        PUT(prev_ftrp, 0);
+        PUT(prev_hdrp, PACK(size, false));
+
+        PUT(FTRP(bp), PACK(size, false));
+        PUT(HDRP(bp), 0);
+    } else if (next) {
+        PUT(next_ftrp, PACK(size, false));
+        PUT(next_hdrp, 0);
+
+        PUT(FTRP(bp), 0);
+        PUT(HDRP(bp), PACK(size, false));
+    }
+
+    return prev ? (void*)((size_t)prev_hdrp + WSIZE) : bp;
+}
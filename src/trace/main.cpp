@@ -0,0 +1,73 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#define STALLOC_TRACE
+#include "../explist/stalloc.hpp"
+#include "trace.hpp"
+
+#define pr_inf "inf[" << __func__ << "]: "
+#define pr_err "err[" << __func__ << "]: "
+
+int main(int argc, char* argv[]) {
+    const char* const path = (argc > 1) ? argv[1] : "stalloc.trace";
+
+    stalloc_t<4096, int> st;
+    stalloc_trace_buf_t<64> tr;
+    st.trace(&tr);
+
+    int* i = nullptr;
+    int* j = nullptr;
+
+    /* Every alloc/free appends one record. Handles are block offsets */
+    std::cout << std::endl << pr_inf << "recording two allocations, a free and a failed allocation" << std::endl;
+    i = st.alloc(4 * sizeof(int));
+    j = st.alloc(8 * sizeof(int));
+    st.free(i);
+    assert(!st.alloc(1000 * sizeof(int)));
+    assert(tr.size() == 4);
+    assert(tr[0].op == alloc_op && tr[0].size == 16 && tr[0].handle == 16);
+    assert(tr[1].op == alloc_op && tr[1].size == 32 && tr[1].handle == 48);
+    assert(tr[2].op == free_op && tr[2].handle == tr[0].handle);
+    assert(tr[3].op == alloc_op && tr[3].handle == stalloc_trace_t::NO_HANDLE);
+    assert(tr[0].ts <= tr[1].ts && tr[1].ts <= tr[2].ts && tr[2].ts <= tr[3].ts);
+
+    /* Invalid frees are not recorded */
+    st.free(i);
+    assert(tr.size() == 4);
+
+    /* Once full, the oldest records are overwritten */
+    std::cout << pr_inf << "recording 100 more operations (ring buffer of 64)" << std::endl;
+    for (int n = 0; n < 50; n++) {
+        i = st.alloc(4 * sizeof(int));
+        st.free(i);
+    }
+    assert(tr.size() == 64);
+    assert(tr[63].op == free_op && tr[62].op == alloc_op);
+    st.free(j);
+    i = j = nullptr;
+
+    /* Dump to a file and read it back */
+    std::cout << pr_inf << "dumping trace to " << path << std::endl;
+    assert(tr.dump(path));
+
+    FILE* const fp = fopen(path, "rb");
+    assert(fp);
+    stalloc_trace_hdr_t hdr;
+    stalloc_rec_t rec;
+    assert(fread(&hdr, sizeof(hdr), 1, fp) == 1);
+    assert(hdr.version == stalloc_trace_t::VERSION && hdr.arena == 4096);
+    assert(hdr.count == 64 && hdr.dropped == 41);
+    assert(fread(&rec, sizeof(rec), 1, fp) == 1);
+    assert(rec.ts == tr[0].ts && rec.handle == tr[0].handle);
+    fclose(fp);
+
+    /* Detached allocators stop recording */
+    st.trace(nullptr);
+    tr.clear();
+    i = st.alloc(4 * sizeof(int));
+    st.free(i);
+    i = nullptr;
+    assert(tr.size() == 0);
+
+    return 0;
+}
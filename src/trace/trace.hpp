@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/* Traced operation */
+enum stalloc_op_t { alloc_op, free_op };
+
+/**
+ * stalloc_rec_t
+ *
+ * One traced operation (16 bytes). The handle is the block's offset
+ * from the start of the allocator, which identifies it for as long
+ * as it is allocated.
+ */
+struct stalloc_rec_t {
+    uint64_t ts : 56;   /* Nanoseconds since the recorder was created */
+    uint64_t op : 8;    /* stalloc_op_t */
+    uint32_t handle;    /* Block offset, or NO_HANDLE for failed allocations */
+    uint32_t size;      /* Requested size (0 for frees) */
+};
+
+/**
+ * stalloc_trace_hdr_t
+ *
+ * Trace file header, followed by count records in the order they
+ * were recorded.
+ */
+struct stalloc_trace_hdr_t {
+    char magic[4];      /* "STTR" */
+    uint32_t version;
+    uint64_t arena;     /* MaxSize of the traced allocator */
+    uint64_t count;     /* Records in the file */
+    uint64_t dropped;   /* Oldest records overwritten before the dump */
+};
+
+static_assert(sizeof(stalloc_rec_t) == 16 && sizeof(stalloc_trace_hdr_t) == 32);
+
+/**
+ * stalloc_trace_t
+ *
+ * Allocation trace recorder. Records are appended to a preallocated
+ * ring buffer of Records entries, overwriting the oldest records once
+ * full, so recording never allocates and costs a clock read and a
+ * 16 byte store per operation.
+ *
+ * Recording hooks are only compiled into stalloc_t when STALLOC_TRACE
+ * is defined. A recorder is then attached with stalloc_t::trace().
+ */
+class stalloc_trace_t {
+    public:
+        static constexpr uint32_t NO_HANDLE = UINT32_MAX;
+        static constexpr uint32_t VERSION = 1;
+
+    private:
+        stalloc_rec_t* const m_recs;
+        const size_t m_cap;
+        uint64_t m_count = 0;
+        uint64_t m_arena = 0;
+        const std::chrono::steady_clock::time_point m_t0 = std::chrono::steady_clock::now();
+
+    protected:
+        stalloc_trace_t(stalloc_rec_t* const recs, const size_t cap) : m_recs(recs), m_cap(cap) {}
+
+    public:
+        stalloc_trace_t(const stalloc_trace_t&) = delete;
+        stalloc_trace_t& operator=(const stalloc_trace_t&) = delete;
+
+        /* Called by stalloc_t::trace() on attach */
+        void attach(const size_t arena) { m_arena = arena; }
+
+        void record(const stalloc_op_t op, const uint32_t handle, const uint32_t size) {
+            const auto ts = std::chrono::steady_clock::now() - m_t0;
+            m_recs[m_count++ % m_cap] = {(uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(ts).count(),
+                                         (uint64_t)op, handle, size};
+        }
+
+        /* Records currently held, oldest first */
+        size_t size() const { return (m_count < m_cap) ? m_count : m_cap; }
+        const stalloc_rec_t& operator[](const size_t i) const { return m_recs[(m_count - size() + i) % m_cap]; }
+
+        /* Discard all records */
+        void clear() { m_count = 0; }
+
+        bool dump(const char* const path) const;
+};
+
+/**
+ * stalloc_trace_buf_t
+ *
+ * Recorder owning a ring buffer of Records entries.
+ */
+template<size_t Records>
+class stalloc_trace_buf_t : public stalloc_trace_t {
+    static_assert(Records > 0);
+
+    private:
+        stalloc_rec_t m_buf[Records];
+
+    public:
+        stalloc_trace_buf_t() : stalloc_trace_t(m_buf, Records) {}
+};
+
+/**
+ * stalloc_trace_t::dump()
+ *
+ * Write the held records, oldest first, to a trace file at path
+ * (see stalloc_trace_hdr_t). Returns false on failure.
+ */
+inline bool stalloc_trace_t::dump(const char* const path) const {
+    FILE* const fp = fopen(path, "wb");
+    if (!fp)
+        return false;
+
+    const stalloc_trace_hdr_t hdr = {{'S', 'T', 'T', 'R'}, VERSION, m_arena, size(), m_count - size()};
+    bool ok = (fwrite(&hdr, sizeof(hdr), 1, fp) == 1);
+
+    /* Oldest records are at the write position once the ring has wrapped */
+    const size_t head = (m_count < m_cap) ? 0 : m_count % m_cap;
+    ok = ok && fwrite(m_recs + head, sizeof(stalloc_rec_t), size() - head, fp) == size() - head;
+    ok = ok && fwrite(m_recs, sizeof(stalloc_rec_t), head, fp) == head;
+
+    return (fclose(fp) == 0) && ok;
+}